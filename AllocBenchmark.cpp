@@ -0,0 +1,232 @@
+/**
+ * @file AllocBenchmark.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Allocation counts of the hot paths of every map layout, with zero-allocation checks.
+ *
+ * @section DESCRIPTION
+ * This file counts the allocations made by steady-state operations (lookups, operator[] on
+ * existing keys, iteration and insert/erase cycles on a warm map) through the counting operator
+ * new. Every path is run once to warm up and once to measure. The program fails if one of the
+ * HashMap paths that are expected not to allocate starts allocating.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include "AllocCounter.hpp"
+#include "BenchUtils.hpp"
+#include "BenchReport.hpp"
+
+#define USAGE_MSG "Usage: AllocBenchmark [entries] [--json <path>]"
+#define BENCHMARK_NAME "AllocBenchmark"
+#define DEFAULT_ENTRIES 10000
+#define ENTRIES_INDEX 1
+#define CYCLE_BATCH 64
+#define SHORT_KEY_LENGTH 8
+#define LONG_KEY_LENGTH 32
+#define NAME_WIDTH 16
+#define TYPE_WIDTH 12
+#define PATH_WIDTH 16
+#define NUMBER_WIDTH 12
+#define PASS "ok"
+#define FAIL "FAIL"
+#define NOT_CHECKED "-"
+
+/**
+ * Runs hot paths twice, counts the allocations of the second run and checks them.
+ */
+class AllocChecker
+{
+    BenchReport &_report;
+    bool _failed = false;
+
+public:
+    /**
+     * Creates a checker that records the allocations of every path in the given report.
+     *
+     * @param report The report to record in.
+     */
+    explicit AllocChecker(BenchReport &report) : _report(report) {}
+
+    /**
+     * Runs a path, prints its allocations per operation and whether it passed its check.
+     *
+     * @param layout The name of the layout.
+     * @param key The name of the key type.
+     * @param path The name of the path.
+     * @param operations How many operations a single run of the path makes.
+     * @param mustNotAllocate True if the path fails when it allocates.
+     * @param run The path to run.
+     */
+    template<typename Operation>
+    void check(const char *layout, const std::string &key, const char *path, int operations,
+               bool mustNotAllocate, Operation run)
+    {
+        run(); // Warm up.
+        AllocStats before = AllocCounter::snapshot();
+        run();
+        AllocStats used = AllocCounter::snapshot() - before;
+
+        _report.add(std::string(layout) + "/" + key + "/" + path, "allocations/op", true,
+                    (double) used.allocations / operations);
+        bool failed = mustNotAllocate && used.allocations != 0;
+        _failed = _failed || failed;
+        std::cout << std::left << std::setw(NAME_WIDTH) << layout << std::setw(TYPE_WIDTH) << key
+                  << std::setw(PATH_WIDTH) << path << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(NUMBER_WIDTH) << (double) used.allocations / operations
+                  << std::setw(NUMBER_WIDTH) << (double) used.requestedBytes / operations
+                  << std::setw(NUMBER_WIDTH) << (!mustNotAllocate ? NOT_CHECKED : failed ? FAIL : PASS) << std::endl;
+    }
+
+    /**
+     * Returns true if a checked path allocated. Otherwise, returns false.
+     *
+     * @return True if a checked path allocated.
+     */
+    bool failed() const noexcept
+    {
+        return _failed;
+    }
+};
+
+/*
+ * Checks the paths every layout has. Only HashMap is required not to allocate, and insertion
+ * with keys that don't fit in the string's inline buffer must allocate for the key copy.
+ */
+template<typename Layout, typename KeyT>
+static void checkLayout(AllocChecker &checker, const std::vector<KeyT> &keys, const std::vector<KeyT> &extra,
+                        int keyLength, bool shortKeys)
+{
+    typename Layout::template Map<KeyT, int> map;
+    for (const KeyT &key : keys)
+    {
+        Layout::insert(map, key, 0);
+    }
+
+    bool enforce = std::is_same<Layout, ChainedLayout>::value;
+    std::string keyName = BenchData<KeyT>::name(keyLength);
+    int count = keys.size(), found = 0;
+    checker.check(Layout::name(), keyName, "find-hit", count, enforce, [&]()
+    {
+        for (const KeyT &key : keys)
+        {
+            found += Layout::contains(map, key);
+        }
+    });
+    checker.check(Layout::name(), keyName, "find-miss", count, enforce, [&]()
+    {
+        for (const KeyT &key : extra)
+        {
+            found += Layout::contains(map, key);
+        }
+    });
+    checker.check(Layout::name(), keyName, "iterate", count, enforce, [&]()
+    {
+        for (const auto &pair : map)
+        {
+            found += pair.second;
+        }
+    });
+    checker.check(Layout::name(), keyName, "insert-erase", (int) extra.size() * 2, enforce && shortKeys, [&]()
+    {
+        for (int i = 0; i < (int) extra.size(); i += CYCLE_BATCH)
+        {
+            int end = std::min((int) extra.size(), i + CYCLE_BATCH);
+            for (int j = i; j < end; j++)
+            {
+                Layout::insert(map, extra[j], j);
+            }
+            for (int j = i; j < end; j++)
+            {
+                Layout::erase(map, extra[j]);
+            }
+        }
+    });
+    doNotOptimize(found);
+}
+
+// Checks the accessors only HashMap has.
+template<typename KeyT>
+static void checkHashMap(AllocChecker &checker, const std::vector<KeyT> &keys, const std::vector<KeyT> &extra,
+                         int keyLength)
+{
+    HashMap<KeyT, int> map;
+    for (const KeyT &key : keys)
+    {
+        map.insert(key, 0);
+    }
+    const HashMap<KeyT, int> &constMap = map;
+
+    std::string keyName = BenchData<KeyT>::name(keyLength);
+    int count = keys.size(), found = 0;
+    checker.check(ChainedLayout::name(), keyName, "at", count, true, [&]()
+    {
+        for (const KeyT &key : keys)
+        {
+            found += constMap.at(key);
+        }
+    });
+    checker.check(ChainedLayout::name(), keyName, "[]-existing", count, true, [&]()
+    {
+        for (const KeyT &key : keys)
+        {
+            map[key]++;
+        }
+    });
+    checker.check(ChainedLayout::name(), keyName, "const []-miss", count, true, [&]()
+    {
+        for (const KeyT &key : extra)
+        {
+            found += constMap[key];
+        }
+    });
+    doNotOptimize(found);
+}
+
+// Checks every path of every layout with the given key type.
+template<typename KeyT>
+static void checkAll(AllocChecker &checker, int count, int keyLength, bool shortKeys)
+{
+    std::vector<KeyT> all = benchItems<KeyT>(2 * count, keyLength);
+    std::vector<KeyT> keys(all.begin(), all.begin() + count), extra(all.begin() + count, all.end());
+    checkLayout<ChainedLayout>(checker, keys, extra, keyLength, shortKeys);
+    checkHashMap(checker, keys, extra, keyLength);
+    checkLayout<StdLayout>(checker, keys, extra, keyLength, shortKeys);
+}
+
+/**
+ * Program's main that receives an optional entry count, prints the allocations and bytes per
+ * operation of every hot path, and fails if a HashMap path that must not allocate did.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    BenchReport report(BENCHMARK_NAME, argc, argv);
+    int count = (argc > ENTRIES_INDEX) ? std::atoi(argv[ENTRIES_INDEX]) : DEFAULT_ENTRIES;
+    if (argc > ENTRIES_INDEX + 1 || count <= 0)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::left << std::setw(NAME_WIDTH) << "layout" << std::setw(TYPE_WIDTH) << "key"
+              << std::setw(PATH_WIDTH) << "path" << std::right << std::setw(NUMBER_WIDTH) << "allocs/op"
+              << std::setw(NUMBER_WIDTH) << "bytes/op" << std::setw(NUMBER_WIDTH) << "check" << std::endl;
+
+    AllocChecker checker(report);
+    checkAll<long long>(checker, count, 0, true);
+    checkAll<std::string>(checker, count, SHORT_KEY_LENGTH, true);
+    checkAll<std::string>(checker, count, LONG_KEY_LENGTH, false);
+    if (checker.failed())
+    {
+        std::cerr << "A hot path allocated." << std::endl;
+        report.write();
+        return EXIT_FAILURE;
+    }
+    return report.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
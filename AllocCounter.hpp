@@ -0,0 +1,193 @@
+/**
+ * @file AllocCounter.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Counting replacements of the global operator new and operator delete.
+ *
+ * @section DESCRIPTION
+ * This header replaces the global allocation functions with ones that forward to malloc and count
+ * allocations, requested bytes and the bytes the allocator actually reserved (malloc_usable_size
+ * plus the chunk header), now and at their peak. It defines non-inline functions, so it must be
+ * included by exactly one translation unit of a program (the benchmark's main file).
+ */
+
+#ifndef SPAMDETECTOR_ALLOCCOUNTER_HPP
+#define SPAMDETECTOR_ALLOCCOUNTER_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+// glibc keeps one size word in front of every chunk.
+#define MALLOC_HEADER_BYTES sizeof(size_t)
+
+/**
+ * Snapshot of the allocation counters.
+ */
+struct AllocStats
+{
+    long long allocations, frees, requestedBytes, reservedBytes;
+
+    /**
+     * Returns the counters that changed from the given earlier snapshot to this one.
+     *
+     * @param before The earlier snapshot.
+     * @return The difference between the snapshots.
+     */
+    AllocStats operator-(const AllocStats &before) const noexcept
+    {
+        return {allocations - before.allocations, frees - before.frees,
+                requestedBytes - before.requestedBytes, reservedBytes - before.reservedBytes};
+    }
+};
+
+/**
+ * Global allocation counters, updated by the replaced operator new and operator delete.
+ */
+class AllocCounter
+{
+    static std::atomic<long long> &_counter(int index) noexcept
+    {
+        static std::atomic<long long> counters[5];
+        return counters[index];
+    }
+
+public:
+    enum
+    {
+        ALLOCATIONS, FREES, REQUESTED, RESERVED, PEAK_RESERVED
+    };
+
+    /**
+     * Records an allocation of the given sizes.
+     *
+     * @param requested The size asked for by the caller.
+     * @param reserved The size the allocator reserved for it.
+     */
+    static void recordAllocation(size_t requested, size_t reserved) noexcept
+    {
+        _counter(ALLOCATIONS).fetch_add(1, std::memory_order_relaxed);
+        _counter(REQUESTED).fetch_add(requested, std::memory_order_relaxed);
+        long long held = _counter(RESERVED).fetch_add(reserved, std::memory_order_relaxed) + reserved;
+        long long peak = _counter(PEAK_RESERVED).load(std::memory_order_relaxed);
+        while (held > peak && !_counter(PEAK_RESERVED).compare_exchange_weak(peak, held, std::memory_order_relaxed))
+        {}
+    }
+
+    /**
+     * Records the release of an allocation that reserved the given size.
+     *
+     * @param reserved The size the allocator had reserved for it.
+     */
+    static void recordFree(size_t reserved) noexcept
+    {
+        _counter(FREES).fetch_add(1, std::memory_order_relaxed);
+        _counter(RESERVED).fetch_sub(reserved, std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns a snapshot of the counters. Requested bytes only ever grow, while reserved bytes
+     * are the bytes currently held.
+     *
+     * @return A snapshot of the counters.
+     */
+    static AllocStats snapshot() noexcept
+    {
+        return {_counter(ALLOCATIONS).load(std::memory_order_relaxed),
+                _counter(FREES).load(std::memory_order_relaxed),
+                _counter(REQUESTED).load(std::memory_order_relaxed),
+                _counter(RESERVED).load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * Returns the most bytes held at once since the last resetPeak().
+     *
+     * @return The most bytes held at once since the last resetPeak().
+     */
+    static long long peakReserved() noexcept
+    {
+        return _counter(PEAK_RESERVED).load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Starts tracking the most bytes held at once from the bytes held now.
+     */
+    static void resetPeak() noexcept
+    {
+        _counter(PEAK_RESERVED).store(_counter(RESERVED).load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+};
+
+/*
+ * Private helper function that allocates through malloc and records the allocation.
+ * Returns nullptr on failure.
+ */
+static void *_countedAllocate(size_t size) noexcept
+{
+    void *ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr != nullptr)
+    {
+        AllocCounter::recordAllocation(size, malloc_usable_size(ptr) + MALLOC_HEADER_BYTES);
+    }
+    return ptr;
+}
+
+// Private helper function that records the release of an allocation and frees it.
+static void _countedFree(void *ptr) noexcept
+{
+    if (ptr != nullptr)
+    {
+        AllocCounter::recordFree(malloc_usable_size(ptr) + MALLOC_HEADER_BYTES);
+        std::free(ptr);
+    }
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = _countedAllocate(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return _countedAllocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return _countedAllocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    _countedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    _countedFree(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    _countedFree(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    _countedFree(ptr);
+}
+
+#endif //SPAMDETECTOR_ALLOCCOUNTER_HPP
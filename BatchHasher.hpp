@@ -0,0 +1,132 @@
+/**
+ * @file BatchHasher.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Hashing of many keys at once, bit-identical to std::hash.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for hashing batches of keys, for HashMap's batch
+ * lookups, batch updates and bulk construction. Strings are hashed by an inline copy of the
+ * string hash of libstdc++ (the 64-bit MurmurHash2 variant of _Hash_bytes), with the same
+ * results, so the hashes index the same buckets as single lookups. Inlined, the hashes of a
+ * batch's keys don't wait for each other, and the last bytes of a key take two overlapping loads
+ * instead of a loop. Other key types and other standard libraries use std::hash key by key.
+ */
+
+#ifndef SPAMDETECTOR_BATCHHASHER_HPP
+#define SPAMDETECTOR_BATCHHASHER_HPP
+
+#include <string>
+#include <cstring>
+#include <climits>
+#include <functional>
+
+#define HASH_SEED 0xc70f6907ULL
+#define HASH_MULTIPLIER 0xc6a4a7935bd1e995ULL
+#define HASH_SHIFT 47
+#define HASH_BLOCK 8
+
+/*
+ * Private helper function that loads the last (fewer than HASH_BLOCK) bytes of a key as
+ * _Hash_bytes does: little-endian, into the low bytes of a word.
+ */
+inline unsigned long long _loadTail(const char *bytes, size_t count) noexcept
+{
+    if (count >= sizeof(unsigned int)) // Two 4-byte loads that overlap in the middle.
+    {
+        unsigned int low, high;
+        std::memcpy(&low, bytes, sizeof(low));
+        std::memcpy(&high, bytes + count - sizeof(high), sizeof(high));
+        return low | ((unsigned long long) high << ((count - sizeof(high)) * CHAR_BIT));
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+    return (unsigned long long) (unsigned char) bytes[0] |
+           (unsigned long long) (unsigned char) bytes[count / 2] << (count / 2 * CHAR_BIT) |
+           (unsigned long long) (unsigned char) bytes[count - 1] << ((count - 1) * CHAR_BIT);
+}
+
+/**
+ * Returns the hash of a byte range, equal to std::hash<std::string> of libstdc++ (on 64-bit
+ * little-endian machines) for the same bytes.
+ *
+ * @param bytes The bytes.
+ * @param length How many bytes there are.
+ * @return The hash.
+ */
+inline size_t hashBytes(const char *bytes, size_t length) noexcept
+{
+    static_assert(sizeof(size_t) == sizeof(unsigned long long), "Computes 64-bit hashes.");
+    unsigned long long hash = HASH_SEED ^ (length * HASH_MULTIPLIER);
+    size_t blocks = length / HASH_BLOCK;
+    for (size_t i = 0; i < blocks; i++)
+    {
+        unsigned long long word;
+        std::memcpy(&word, bytes + i * HASH_BLOCK, sizeof(word));
+        word *= HASH_MULTIPLIER;
+        word = (word ^ (word >> HASH_SHIFT)) * HASH_MULTIPLIER;
+        hash = (hash ^ word) * HASH_MULTIPLIER;
+    }
+    if (length % HASH_BLOCK != 0)
+    {
+        hash = (hash ^ _loadTail(bytes + blocks * HASH_BLOCK, length % HASH_BLOCK)) * HASH_MULTIPLIER;
+    }
+    hash = (hash ^ (hash >> HASH_SHIFT)) * HASH_MULTIPLIER;
+    return hash ^ (hash >> HASH_SHIFT);
+}
+
+/**
+ * Hashes batches of keys with std::hash, key by key.
+ *
+ * @tparam KeyT The key type.
+ */
+template<typename KeyT>
+struct BatchHash
+{
+    /**
+     * Computes the hashes of a batch of keys.
+     *
+     * @param keys Pointers to the keys.
+     * @param count How many keys there are.
+     * @param hashes For every key, its std::hash.
+     */
+    static void hash(const KeyT *const *keys, int count, size_t *hashes) noexcept
+    {
+        for (int i = 0; i < count; i++)
+        {
+            hashes[i] = std::hash<KeyT>{}(*keys[i]);
+        }
+    }
+};
+
+/**
+ * Hashes batches of strings inline, with the same results as std::hash<std::string>.
+ */
+template<>
+struct BatchHash<std::string>
+{
+    /**
+     * Computes the hashes of a batch of strings.
+     *
+     * @param keys Pointers to the strings.
+     * @param count How many strings there are.
+     * @param hashes For every string, its std::hash.
+     */
+    static void hash(const std::string *const *keys, int count, size_t *hashes) noexcept
+    {
+        for (int i = 0; i < count; i++)
+        {
+#if defined(__GLIBCXX__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            hashes[i] = hashBytes(keys[i]->data(), keys[i]->size());
+#else
+            hashes[i] = std::hash<std::string>{}(*keys[i]);
+#endif
+        }
+    }
+};
+
+#endif //SPAMDETECTOR_BATCHHASHER_HPP
@@ -0,0 +1,435 @@
+/**
+ * @file BenchCompare.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Compares two JSON benchmark reports and flags significant regressions.
+ *
+ * @section DESCRIPTION
+ * This file reads a baseline and a candidate report written by a benchmark's "--json" option,
+ * matches their results by name, and prints the change of every result's mean with a bootstrapped
+ * 95% confidence interval. A result regresses when the whole interval is worse than the threshold.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include "BenchReport.hpp"
+#include "HashMap.hpp"
+
+#define USAGE_MSG "Usage: BenchCompare <baseline.json> <candidate.json> [threshold %]"
+#define PARSE_ERROR "ERROR: Invalid benchmark report "
+#define BASELINE_INDEX 1
+#define CANDIDATE_INDEX 2
+#define THRESHOLD_INDEX 3
+#define MIN_ARGS 3
+#define MAX_ARGS 4
+#define DEFAULT_THRESHOLD 5.0
+#define BOOTSTRAP_ROUNDS 2000
+#define BOOTSTRAP_SEED 42
+#define PERCENT 100.0
+#define NAME_WIDTH 48
+#define NUMBER_WIDTH 12
+
+const double CONFIDENCE_LOW = 0.025, CONFIDENCE_HIGH = 0.975;
+
+/**
+ * Exception for reports that can't be read.
+ */
+class ReportException : public std::exception
+{
+    std::string _message;
+
+public:
+    explicit ReportException(const std::string &path) : _message(PARSE_ERROR + path) {}
+
+    const char *what() const noexcept override
+    {
+        return _message.c_str();
+    }
+};
+
+/**
+ * Reader of the JSON written by BenchReport (a subset of JSON: objects, arrays, strings, numbers
+ * and literals). Only the "results" array is kept.
+ */
+class ReportReader
+{
+    std::string _text, _path;
+    size_t _pos = 0;
+    std::vector<std::pair<std::string, std::string>> _environment;
+
+    void _skipSpace()
+    {
+        while (_pos < _text.size() && std::isspace((unsigned char) _text[_pos]))
+        {
+            _pos++;
+        }
+    }
+
+    void _expect(char ch)
+    {
+        _skipSpace();
+        if (_pos >= _text.size() || _text[_pos] != ch)
+        {
+            throw ReportException(_path);
+        }
+        _pos++;
+    }
+
+    bool _peek(char ch)
+    {
+        _skipSpace();
+        return _pos < _text.size() && _text[_pos] == ch;
+    }
+
+    std::string _string()
+    {
+        _expect('"');
+        std::string st;
+        while (_pos < _text.size() && _text[_pos] != '"')
+        {
+            if (_text[_pos] == '\\' && ++_pos < _text.size() && _text[_pos] == 'u')
+            {
+                st += (char) std::stoi(_text.substr(_pos + 1, 4), nullptr, 16);
+                _pos += 5;
+                continue;
+            }
+            st += _text[_pos++];
+        }
+        _expect('"');
+        return st;
+    }
+
+    double _number()
+    {
+        _skipSpace();
+        size_t used = 0;
+        double value;
+        try
+        {
+            value = std::stod(_text.substr(_pos, 32), &used);
+        }
+        catch (std::exception &)
+        {
+            throw ReportException(_path);
+        }
+        _pos += used;
+        return value;
+    }
+
+    // Skips any value.
+    void _skip()
+    {
+        _skipSpace();
+        if (_peek('"'))
+        {
+            _string();
+        }
+        else if (_peek('{') || _peek('['))
+        {
+            char close = (_text[_pos] == '{') ? '}' : ']';
+            _pos++;
+            while (!_peek(close))
+            {
+                if (close == '}')
+                {
+                    _string();
+                    _expect(':');
+                }
+                _skip();
+                if (!_peek(close))
+                {
+                    _expect(',');
+                }
+            }
+            _pos++;
+        }
+        else if (_text.compare(_pos, 4, "true") == 0 || _text.compare(_pos, 4, "null") == 0)
+        {
+            _pos += 4;
+        }
+        else if (_text.compare(_pos, 5, "false") == 0)
+        {
+            _pos += 5;
+        }
+        else
+        {
+            _number();
+        }
+    }
+
+    BenchResult _result()
+    {
+        BenchResult result{"", "", true, {}};
+        _expect('{');
+        while (!_peek('}'))
+        {
+            std::string key = _string();
+            _expect(':');
+            if (key == "name")
+            {
+                result.name = _string();
+            }
+            else if (key == "unit")
+            {
+                result.unit = _string();
+            }
+            else if (key == "lower_is_better")
+            {
+                _skipSpace();
+                result.lowerIsBetter = _text.compare(_pos, 4, "true") == 0;
+                _skip();
+            }
+            else if (key == "samples")
+            {
+                _expect('[');
+                while (!_peek(']'))
+                {
+                    result.samples.push_back(_number());
+                    if (!_peek(']'))
+                    {
+                        _expect(',');
+                    }
+                }
+                _pos++;
+            }
+            else
+            {
+                _skip();
+            }
+            if (!_peek('}'))
+            {
+                _expect(',');
+            }
+        }
+        _pos++;
+        return result;
+    }
+
+public:
+    /**
+     * Reads the report at the given path. A missing report reads as empty, which results() rejects.
+     *
+     * @param path The path of the report.
+     */
+    explicit ReportReader(const std::string &path) : _path(path)
+    {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        _text = buffer.str();
+    }
+
+    /**
+     * Returns the results of the report.
+     *
+     * @throws ReportException if the report is invalid.
+     * @return The results of the report.
+     */
+    std::vector<BenchResult> results()
+    {
+        std::vector<BenchResult> results;
+        _pos = 0;
+        _expect('{');
+        while (!_peek('}'))
+        {
+            std::string key = _string();
+            _expect(':');
+            if (key == "results")
+            {
+                _expect('[');
+                while (!_peek(']'))
+                {
+                    results.push_back(_result());
+                    if (!_peek(']'))
+                    {
+                        _expect(',');
+                    }
+                }
+                _pos++;
+            }
+            else if (key == "environment")
+            {
+                _expect('{');
+                while (!_peek('}'))
+                {
+                    std::string name = _string();
+                    _expect(':');
+                    _environment.emplace_back(name, _string());
+                    if (!_peek('}'))
+                    {
+                        _expect(',');
+                    }
+                }
+                _pos++;
+            }
+            else
+            {
+                _skip();
+            }
+            if (!_peek('}'))
+            {
+                _expect(',');
+            }
+        }
+        return results;
+    }
+
+    /**
+     * Returns the environment the report was made in, as read by results().
+     *
+     * @return Pairs of environment field and value.
+     */
+    const std::vector<std::pair<std::string, std::string>> &environment() const noexcept
+    {
+        return _environment;
+    }
+};
+
+// Returns the mean of the given samples.
+static double mean(const std::vector<double> &samples)
+{
+    double sum = 0;
+    for (double sample : samples)
+    {
+        sum += sample;
+    }
+    return sum / samples.size();
+}
+
+/*
+ * Returns a bootstrapped confidence interval of the relative change (candidate mean over
+ * baseline mean, minus one) by resampling both sides with replacement.
+ */
+static std::pair<double, double> bootstrapChange(const std::vector<double> &baseline,
+                                                 const std::vector<double> &candidate, std::mt19937 &random)
+{
+    std::uniform_int_distribution<size_t> pickBaseline(0, baseline.size() - 1), pickCandidate(0, candidate.size() - 1);
+    std::vector<double> changes(BOOTSTRAP_ROUNDS);
+    for (double &change : changes)
+    {
+        double baselineSum = 0, candidateSum = 0;
+        for (size_t i = 0; i < baseline.size(); i++)
+        {
+            baselineSum += baseline[pickBaseline(random)];
+        }
+        for (size_t i = 0; i < candidate.size(); i++)
+        {
+            candidateSum += candidate[pickCandidate(random)];
+        }
+        change = (candidateSum / candidate.size()) / (baselineSum / baseline.size()) - 1;
+    }
+    std::sort(changes.begin(), changes.end());
+    return {changes[(size_t) (CONFIDENCE_LOW * (BOOTSTRAP_ROUNDS - 1))],
+            changes[(size_t) (CONFIDENCE_HIGH * (BOOTSTRAP_ROUNDS - 1))]};
+}
+
+/**
+ * Program's main that receives two report paths and an optional regression threshold (percent),
+ * prints the change of every common result and exits with failure if any result regressed.
+ * Results with a single sample on either side get no interval and are never flagged.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    double threshold = (argc > THRESHOLD_INDEX) ? std::atof(argv[THRESHOLD_INDEX]) / PERCENT : DEFAULT_THRESHOLD / PERCENT;
+    if (argc < MIN_ARGS || argc > MAX_ARGS || threshold < 0)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<BenchResult> baseline, candidate;
+    ReportReader baselineReader(argv[BASELINE_INDEX]), candidateReader(argv[CANDIDATE_INDEX]);
+    try
+    {
+        baseline = baselineReader.results();
+        candidate = candidateReader.results();
+    }
+    catch (ReportException &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Results from different machines or builds aren't comparable, so say what differs.
+    for (const auto &field : candidateReader.environment())
+    {
+        for (const auto &baseField : baselineReader.environment())
+        {
+            if (baseField.first == field.first && baseField.second != field.second && field.first != "time")
+            {
+                std::cout << field.first << ": " << baseField.second << " -> " << field.second << std::endl;
+            }
+        }
+    }
+
+    HashMap<std::string, int> baselineIndex;
+    for (int i = 0; i < (int) baseline.size(); i++)
+    {
+        baselineIndex.insert(baseline[i].name, i);
+    }
+
+    std::cout << std::left << std::setw(NAME_WIDTH) << "result" << std::right << std::setw(NUMBER_WIDTH) << "baseline"
+              << std::setw(NUMBER_WIDTH) << "candidate" << std::setw(NUMBER_WIDTH) << "change %"
+              << std::setw(2 * NUMBER_WIDTH) << "95% interval" << "  verdict" << std::endl;
+    std::mt19937 random(BOOTSTRAP_SEED);
+    int regressions = 0;
+    for (const BenchResult &result : candidate)
+    {
+        if (!baselineIndex.containsKey(result.name) || result.samples.empty())
+        {
+            continue;
+        }
+        const BenchResult &base = baseline[baselineIndex.at(result.name)];
+        if (base.samples.empty() || mean(base.samples) == 0)
+        {
+            continue;
+        }
+
+        double change = mean(result.samples) / mean(base.samples) - 1;
+        std::ostringstream interval, verdict;
+        interval << std::fixed << std::setprecision(1);
+        if (base.samples.size() > 1 && result.samples.size() > 1)
+        {
+            std::pair<double, double> bounds = bootstrapChange(base.samples, result.samples, random);
+            interval << "[" << bounds.first * PERCENT << ", " << bounds.second * PERCENT << "]";
+            double worseBound = result.lowerIsBetter ? bounds.first : -bounds.second;
+            double betterBound = result.lowerIsBetter ? -bounds.second : bounds.first;
+            if (worseBound > threshold)
+            {
+                verdict << "REGRESSION";
+                regressions++;
+            }
+            else if (betterBound > threshold)
+            {
+                verdict << "improvement";
+            }
+        }
+        else
+        {
+            interval << "n/a";
+        }
+
+        std::cout << std::left << std::setw(NAME_WIDTH) << result.name << std::right << std::setprecision(2)
+                  << std::fixed << std::setw(NUMBER_WIDTH) << mean(base.samples)
+                  << std::setw(NUMBER_WIDTH) << mean(result.samples) << std::setw(NUMBER_WIDTH) << change * PERCENT
+                  << std::setw(2 * NUMBER_WIDTH) << interval.str() << "  " << verdict.str() << std::endl;
+    }
+
+    if (regressions > 0)
+    {
+        std::cerr << regressions << " significant regression(s) beyond " << threshold * PERCENT << "%." << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
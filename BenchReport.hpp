@@ -0,0 +1,203 @@
+/**
+ * @file BenchReport.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Machine-readable (JSON) benchmark results with environment metadata.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for the report every benchmark fills with its results
+ * and writes, when run with "--json <path>", together with the CPU model, compiler, compiler flags
+ * and commit it was built from. BenchCompare reads two such reports.
+ */
+
+#ifndef SPAMDETECTOR_BENCHREPORT_HPP
+#define SPAMDETECTOR_BENCHREPORT_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+#include <cstring>
+
+#ifndef BENCH_COMMIT
+#define BENCH_COMMIT "unknown"
+#endif
+#ifndef BENCH_FLAGS
+#define BENCH_FLAGS "unknown"
+#endif
+
+#if defined(__clang__)
+#define COMPILER_NAME "clang "
+#else
+#define COMPILER_NAME "gcc "
+#endif
+
+#define JSON_FLAG "--json"
+#define CPUINFO_PATH "/proc/cpuinfo"
+#define CPU_MODEL_FIELD "model name"
+#define UNKNOWN "unknown"
+#define JSON_PRECISION 10
+#define TIME_FORMAT "%Y-%m-%dT%H:%M:%SZ"
+#define TIME_BUFFER 32
+
+/**
+ * A single measured quantity of a benchmark, with one sample per repetition.
+ */
+struct BenchResult
+{
+    std::string name, unit;
+    bool lowerIsBetter;
+    std::vector<double> samples;
+};
+
+/**
+ * Results of a benchmark run, written as JSON on request.
+ */
+class BenchReport
+{
+    std::string _benchmark, _path;
+    std::vector<BenchResult> _results;
+
+    // Returns the given string as a JSON string literal.
+    static std::string _quote(const std::string &st)
+    {
+        std::ostringstream out;
+        out << '"';
+        for (char ch : st)
+        {
+            if (ch == '"' || ch == '\\')
+            {
+                out << '\\' << ch;
+            }
+            else if ((unsigned char) ch < ' ')
+            {
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int) ch << std::dec;
+            }
+            else
+            {
+                out << ch;
+            }
+        }
+        out << '"';
+        return out.str();
+    }
+
+    // Returns the model name of the CPU.
+    static std::string _cpuModel()
+    {
+        std::ifstream cpuinfo(CPUINFO_PATH);
+        for (std::string line; std::getline(cpuinfo, line);)
+        {
+            std::string::size_type colon = line.find(':');
+            if (line.compare(0, std::strlen(CPU_MODEL_FIELD), CPU_MODEL_FIELD) == 0 && colon != std::string::npos)
+            {
+                return line.substr(line.find_first_not_of(' ', colon + 1));
+            }
+        }
+        return UNKNOWN;
+    }
+
+public:
+    /**
+     * Creates an empty report for the given benchmark, and removes "--json <path>" from the
+     * program's arguments if it is there.
+     *
+     * @param benchmark The name of the benchmark.
+     * @param argc Count of args (updated).
+     * @param argv Args values (updated).
+     */
+    BenchReport(const std::string &benchmark, int &argc, char **argv) : _benchmark(benchmark)
+    {
+        for (int i = 1; i + 1 < argc; i++)
+        {
+            if (std::strcmp(argv[i], JSON_FLAG) == 0)
+            {
+                _path = argv[i + 1];
+                for (int j = i; j + 2 <= argc; j++)
+                {
+                    argv[j] = argv[j + 2];
+                }
+                argc -= 2;
+                break;
+            }
+        }
+    }
+
+    /**
+     * Returns the samples of the result with the given name, creating it if needed.
+     *
+     * @param name The name of the result.
+     * @param unit The unit of the result.
+     * @param lowerIsBetter True if smaller values are improvements.
+     * @return The samples of the result.
+     */
+    std::vector<double> &samples(const std::string &name, const std::string &unit, bool lowerIsBetter)
+    {
+        for (BenchResult &result : _results)
+        {
+            if (result.name == name)
+            {
+                return result.samples;
+            }
+        }
+        _results.push_back({name, unit, lowerIsBetter, {}});
+        return _results.back().samples;
+    }
+
+    /**
+     * Adds a sample to the result with the given name.
+     *
+     * @param name The name of the result.
+     * @param unit The unit of the result.
+     * @param lowerIsBetter True if smaller values are improvements.
+     * @param value The sample to add.
+     */
+    void add(const std::string &name, const std::string &unit, bool lowerIsBetter, double value)
+    {
+        samples(name, unit, lowerIsBetter).push_back(value);
+    }
+
+    /**
+     * Writes the report to the path given by "--json", if there was one.
+     *
+     * @return False if writing failed. Otherwise, true.
+     */
+    bool write() const
+    {
+        if (_path.empty())
+        {
+            return true;
+        }
+
+        char time[TIME_BUFFER];
+        std::time_t now = std::time(nullptr);
+        std::strftime(time, sizeof(time), TIME_FORMAT, std::gmtime(&now));
+
+        std::ofstream out(_path);
+        out << std::setprecision(JSON_PRECISION);
+        out << "{\n  \"benchmark\": " << _quote(_benchmark) << ",\n  \"environment\": {"
+            << "\n    \"cpu\": " << _quote(_cpuModel()) << ",\n    \"compiler\": " << _quote(COMPILER_NAME __VERSION__)
+            << ",\n    \"flags\": " << _quote(BENCH_FLAGS) << ",\n    \"commit\": " << _quote(BENCH_COMMIT)
+            << ",\n    \"time\": " << _quote(time) << "\n  },\n  \"results\": [";
+        for (int i = 0; i < (int) _results.size(); i++)
+        {
+            const BenchResult &result = _results[i];
+            out << (i ? "," : "") << "\n    {\"name\": " << _quote(result.name) << ", \"unit\": "
+                << _quote(result.unit) << ", \"lower_is_better\": " << (result.lowerIsBetter ? "true" : "false")
+                << ", \"samples\": [";
+            for (int j = 0; j < (int) result.samples.size(); j++)
+            {
+                out << (j ? ", " : "") << result.samples[j];
+            }
+            out << "]}";
+        }
+        out << "\n  ]\n}\n";
+        return (bool) out;
+    }
+};
+
+#endif //SPAMDETECTOR_BENCHREPORT_HPP
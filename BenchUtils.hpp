@@ -0,0 +1,303 @@
+/**
+ * @file BenchUtils.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Shared helpers for the HashMap benchmarks.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for the data generators, map layout adapters and
+ * process measurements shared by the benchmark programs.
+ */
+
+#ifndef SPAMDETECTOR_BENCHUTILS_HPP
+#define SPAMDETECTOR_BENCHUTILS_HPP
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <unordered_map>
+#include <unistd.h>
+#include "HashMap.hpp"
+#include "IntHashMap.hpp"
+
+#define LETTERS 26
+#define FIRST_LETTER 'a'
+#define STATM_PATH "/proc/self/statm"
+
+/**
+ * Scrambles an integer with a bijective mixer, so that generated data isn't sequential.
+ *
+ * @param x The integer to scramble.
+ * @return The scrambled integer.
+ */
+inline unsigned long long benchMix(unsigned long long x) noexcept
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * Generator of distinct benchmark data of a given type.
+ *
+ * @tparam T The type of data to generate.
+ */
+template<typename T>
+struct BenchData;
+
+/**
+ * Generator of distinct ints.
+ */
+template<>
+struct BenchData<int>
+{
+    /**
+     * Returns the i-th distinct int (the length is ignored).
+     */
+    static int make(long long i, int)
+    {
+        unsigned int x = (unsigned int) i * 0x9e3779b1U; // Odd multiplier, so still distinct.
+        return (int) (x ^ (x >> 16));
+    }
+
+    /**
+     * Returns the name of this type.
+     */
+    static std::string name(int)
+    {
+        return "int";
+    }
+};
+
+/**
+ * Generator of distinct long longs.
+ */
+template<>
+struct BenchData<long long>
+{
+    /**
+     * Returns the i-th distinct long long (the length is ignored).
+     */
+    static long long make(long long i, int)
+    {
+        return (long long) benchMix(i);
+    }
+
+    /**
+     * Returns the name of this type.
+     */
+    static std::string name(int)
+    {
+        return "long long";
+    }
+};
+
+/**
+ * Generator of distinct lowercase strings.
+ */
+template<>
+struct BenchData<std::string>
+{
+    /**
+     * Returns the i-th distinct string of the given length (distinct while i < 25^(length - 1)).
+     */
+    static std::string make(long long i, int length)
+    {
+        std::string st(length, FIRST_LETTER);
+        unsigned long long noise = benchMix(i);
+        for (int j = 0; j < length; j++)
+        {
+            st[j] = (char) (FIRST_LETTER + (noise >> (j % 8 * 8)) % LETTERS);
+        }
+        // Embed i at the end, in base 25 without the last letter, which then ends it, so that the
+        // noise before it can't make two strings equal.
+        int j = length - 1;
+        for (; j >= 0 && i > 0; j--, i /= LETTERS - 1)
+        {
+            st[j] = (char) (FIRST_LETTER + i % (LETTERS - 1));
+        }
+        if (j >= 0)
+        {
+            st[j] = (char) (FIRST_LETTER + LETTERS - 1);
+        }
+        return st;
+    }
+
+    /**
+     * Returns the name of this type with the given length.
+     */
+    static std::string name(int length)
+    {
+        return "string" + std::to_string(length);
+    }
+};
+
+/**
+ * Returns the first count distinct items of the given type and length.
+ *
+ * @tparam T The type of data to generate.
+ * @param count How many items to generate.
+ * @param length The length of generated strings.
+ * @return A vector of count distinct items.
+ */
+template<typename T>
+std::vector<T> benchItems(int count, int length)
+{
+    std::vector<T> items;
+    items.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        items.push_back(BenchData<T>::make(i, length));
+    }
+    return items;
+}
+
+/**
+ * The chained HashMap layout.
+ * Every layout adapter gives its map type and name, and the operations benchmarks drive.
+ */
+struct ChainedLayout
+{
+    template<typename KeyT, typename ValueT>
+    using Map = HashMap<KeyT, ValueT>;
+
+    static const char *name()
+    {
+        return "HashMap";
+    }
+
+    template<typename KeyT, typename ValueT>
+    static void insert(Map<KeyT, ValueT> &map, const KeyT &key, const ValueT &value)
+    {
+        map.insert(key, value);
+    }
+
+    template<typename KeyT, typename ValueT>
+    static bool contains(const Map<KeyT, ValueT> &map, const KeyT &key)
+    {
+        return map.containsKey(key);
+    }
+
+    template<typename KeyT, typename ValueT>
+    static void erase(Map<KeyT, ValueT> &map, const KeyT &key)
+    {
+        map.erase(key);
+    }
+
+    template<typename KeyT, typename ValueT>
+    static long long capacity(const Map<KeyT, ValueT> &map)
+    {
+        return map.capacity();
+    }
+};
+
+/**
+ * The flat layout for integer keys.
+ */
+struct IntLayout
+{
+    template<typename KeyT, typename ValueT>
+    using Map = IntHashMap<KeyT, ValueT>;
+
+    static const char *name()
+    {
+        return "IntHashMap";
+    }
+
+    template<typename KeyT, typename ValueT>
+    static void insert(Map<KeyT, ValueT> &map, const KeyT &key, const ValueT &value)
+    {
+        map.insert(key, value);
+    }
+
+    template<typename KeyT, typename ValueT>
+    static bool contains(const Map<KeyT, ValueT> &map, const KeyT &key)
+    {
+        return map.containsKey(key);
+    }
+
+    template<typename KeyT, typename ValueT>
+    static void erase(Map<KeyT, ValueT> &map, const KeyT &key)
+    {
+        map.erase(key);
+    }
+
+    template<typename KeyT, typename ValueT>
+    static long long capacity(const Map<KeyT, ValueT> &map)
+    {
+        return map.capacity();
+    }
+};
+
+/**
+ * The standard library's node-based layout, for reference.
+ */
+struct StdLayout
+{
+    template<typename KeyT, typename ValueT>
+    using Map = std::unordered_map<KeyT, ValueT>;
+
+    static const char *name()
+    {
+        return "unordered_map";
+    }
+
+    template<typename KeyT, typename ValueT>
+    static void insert(Map<KeyT, ValueT> &map, const KeyT &key, const ValueT &value)
+    {
+        map.emplace(key, value);
+    }
+
+    template<typename KeyT, typename ValueT>
+    static bool contains(const Map<KeyT, ValueT> &map, const KeyT &key)
+    {
+        return map.count(key) != 0;
+    }
+
+    template<typename KeyT, typename ValueT>
+    static void erase(Map<KeyT, ValueT> &map, const KeyT &key)
+    {
+        map.erase(key);
+    }
+
+    template<typename KeyT, typename ValueT>
+    static long long capacity(const Map<KeyT, ValueT> &map)
+    {
+        return map.bucket_count();
+    }
+};
+
+/**
+ * Returns the current resident set size of this process in bytes.
+ *
+ * @return The current resident set size of this process in bytes, or 0 if unknown.
+ */
+inline long long residentBytes()
+{
+    std::ifstream statm(STATM_PATH);
+    long long pages = 0, resident = 0;
+    if (statm >> pages >> resident)
+    {
+        return resident * sysconf(_SC_PAGESIZE);
+    }
+    return 0;
+}
+
+/**
+ * Keeps the compiler from optimizing away the computation of a value.
+ *
+ * @param value The value to keep.
+ */
+template<typename T>
+inline void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif //SPAMDETECTOR_BENCHUTILS_HPP
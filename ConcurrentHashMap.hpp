@@ -0,0 +1,441 @@
+/**
+ * @file ConcurrentHashMap.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Thread-safe HashMap with per-bucket locks and cooperative resizing.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for a map that many threads can use at once. Every
+ * bucket of the table is a row of pairs behind its own small spin lock, so threads only wait for
+ * each other on the same bucket. When the table outgrows its load factor, a table of twice the
+ * capacity is attached to it, and its buckets are migrated in stripes of MIGRATION_STRIPE: every
+ * thread that touches the map while a migration is going on first claims the next stripe and
+ * moves it (the pairs of bucket i split between buckets i and i + capacity of the new table), so
+ * growth takes as many hands as there are threads and no thread moves more than a stripe at a
+ * time. A migrated bucket is marked as forwarded, and an operation that finds its bucket forwarded
+ * goes on to the new table. The thread that migrates the last bucket makes the new table current.
+ * A bucket whose pairs can't be moved (for lack of memory) is left as it was, and once every stripe
+ * is claimed, the next thread to help sweeps the table for such buckets.
+ * Old tables (their empty buckets only) are kept until the map is destroyed, since a thread may
+ * still be reading their forwarding marks; together they are smaller than the current table.
+ */
+
+#ifndef SPAMDETECTOR_CONCURRENTHASHMAP_HPP
+#define SPAMDETECTOR_CONCURRENTHASHMAP_HPP
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include "HashMap.hpp"
+
+#define CONCURRENT_MIN_CAPACITY 16
+#define CONCURRENT_MAX_LOAD 0.75
+#define MIGRATION_STRIPE 256
+
+/**
+ * Thread-safe map from keys to values, that grows with the help of the threads using it.
+ * Values are copied in and out under their bucket's lock, never handed out by reference.
+ *
+ * @tparam KeyT The key type.
+ * @tparam ValueT The value type.
+ */
+template<typename KeyT, typename ValueT>
+class ConcurrentHashMap
+{
+    typedef std::vector<std::pair<KeyT, ValueT> *> HashRow;
+
+    // A bucket: its lock, whether its pairs moved to the next table, and its pairs.
+    struct _Bin
+    {
+        std::atomic<bool> locked{false};
+        bool forwarded = false;
+        HashRow row;
+    };
+
+    // A table, with the state of its migration to the next one (if there is one).
+    struct _Table
+    {
+        int capacity;
+        std::unique_ptr<_Bin[]> bins;
+        std::atomic<_Table *> next{nullptr};
+        std::atomic<int> claimed{0}, migrated{0};
+        std::atomic<bool> unfinished{false}; // A claimed bucket failed to migrate and needs a sweep.
+
+        explicit _Table(int capacity) : capacity(capacity), bins(new _Bin[capacity])
+        {}
+    };
+
+    // Holds the lock of a bucket for a scope.
+    class _BinLock
+    {
+        _Bin &_bin;
+
+    public:
+        explicit _BinLock(_Bin &bin) noexcept : _bin(bin)
+        {
+            while (_bin.locked.exchange(true, std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        ~_BinLock()
+        {
+            _bin.locked.store(false, std::memory_order_release);
+        }
+    };
+
+    std::atomic<_Table *> _current;
+    std::atomic<int> _size;
+    std::vector<std::unique_ptr<_Table>> _tables; // Every table so far; changed under _resizeMutex.
+    std::mutex _resizeMutex;
+
+    // Returns the position of a key in its row, or -1 if it isn't there.
+    static int _indexIn(const HashRow &row, const KeyT &key) noexcept
+    {
+        for (int i = 0; i < (int) row.size(); i++)
+        {
+            if (row[i]->first == key)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Adds a new pair to a row, without leaking it if the row can't grow.
+    static void _addPair(HashRow &row, const KeyT &key, const ValueT &value)
+    {
+        std::unique_ptr<std::pair<KeyT, ValueT>> pair(new std::pair<KeyT, ValueT>(key, value));
+        row.push_back(pair.get());
+        pair.release();
+    }
+
+    // Moves the pairs of a bucket to the two buckets of the next table that they hash to. Returns
+    // false if they already moved. Room is made first, so a failed allocation leaves it as it was.
+    bool _migrate(_Table &table, _Table &next, int i)
+    {
+        _BinLock lock(table.bins[i]);
+        if (table.bins[i].forwarded)
+        {
+            return false;
+        }
+        _BinLock low(next.bins[i]), high(next.bins[i + table.capacity]);
+        HashRow &row = table.bins[i].row;
+        int up = 0;
+        for (auto *pair : row)
+        {
+            up += (std::hash<KeyT>{}(pair->first) & table.capacity) != 0; // The new hash bit.
+        }
+        next.bins[i].row.reserve(row.size() - up);
+        next.bins[i + table.capacity].row.reserve(up);
+        for (auto *pair : row)
+        {
+            bool isUp = (std::hash<KeyT>{}(pair->first) & table.capacity) != 0;
+            next.bins[isUp ? i + table.capacity : i].row.push_back(pair);
+        }
+        HashRow().swap(row);
+        table.bins[i].forwarded = true;
+        return true;
+    }
+
+    // Migrates the buckets of a range that haven't moved yet, and makes the next table current once
+    // every bucket has. If one fails, the range's claim can't be handed back (claims only grow), so
+    // the table is marked for a sweep by the next helper and the exception is rethrown.
+    void _migrateRange(_Table &table, _Table &next, int first, int last)
+    {
+        int moved = 0;
+        try
+        {
+            for (int i = first; i < last; i++)
+            {
+                moved += _migrate(table, next, i);
+            }
+        }
+        catch (...)
+        {
+            table.unfinished.store(true, std::memory_order_release);
+            _countMigrated(table, next, moved);
+            throw;
+        }
+        _countMigrated(table, next, moved);
+    }
+
+    // Counts migrated buckets, making the next table current if they were the last.
+    void _countMigrated(_Table &table, _Table &next, int moved) noexcept
+    {
+        if (moved > 0 && table.migrated.fetch_add(moved, std::memory_order_acq_rel) + moved == table.capacity)
+        {
+            _current.store(&next, std::memory_order_release);
+        }
+    }
+
+    // If a table is being migrated, claims and migrates its next stripe of buckets, or once they are
+    // all claimed, sweeps the table for buckets that failed to migrate (if any did).
+    void _help(_Table &table)
+    {
+        _Table *next = table.next.load(std::memory_order_acquire);
+        if (next == nullptr)
+        {
+            return;
+        }
+        if (table.claimed.load(std::memory_order_relaxed) >= table.capacity)
+        {
+            if (table.unfinished.load(std::memory_order_relaxed) &&
+                table.unfinished.exchange(false, std::memory_order_acquire))
+            {
+                _migrateRange(table, *next, 0, table.capacity);
+            }
+            return;
+        }
+        int first = table.claimed.fetch_add(MIGRATION_STRIPE, std::memory_order_relaxed);
+        if (first >= table.capacity)
+        {
+            return;
+        }
+        _migrateRange(table, *next, first, std::min(first + MIGRATION_STRIPE, table.capacity));
+    }
+
+    // Attaches a table of twice the capacity to the current one, unless a migration is going on.
+    void _grow(_Table &table)
+    {
+        std::unique_lock<std::mutex> lock(_resizeMutex, std::try_to_lock);
+        if (!lock.owns_lock() || &table != _current.load(std::memory_order_acquire) ||
+            table.next.load(std::memory_order_relaxed) != nullptr)
+        {
+            return;
+        }
+        _tables.emplace_back(new _Table(table.capacity * CHANGE_FACTOR));
+        table.next.store(_tables.back().get(), std::memory_order_release);
+    }
+
+    // Runs an operation on the bucket of a key, under its lock, following forwarded buckets to the
+    // table that has it now. Helps a migration first, if one is going on. Returns the table used.
+    template<typename Operation>
+    _Table &_withBin(const KeyT &key, Operation operation)
+    {
+        _Table *table = _current.load(std::memory_order_acquire);
+        _help(*table);
+        size_t hash = std::hash<KeyT>{}(key);
+        for (;;)
+        {
+            _Bin &bin = table->bins[hash & (table->capacity - 1)];
+            _BinLock lock(bin);
+            if (!bin.forwarded)
+            {
+                operation(bin.row);
+                return *table;
+            }
+            table = table->next.load(std::memory_order_acquire);
+        }
+    }
+
+    // Counts an inserted pair, and starts growing the table if it's too loaded.
+    void _added(_Table &table)
+    {
+        if (_size.fetch_add(1, std::memory_order_relaxed) + 1 > CONCURRENT_MAX_LOAD * table.capacity)
+        {
+            _grow(table);
+        }
+    }
+
+public:
+    /**
+     * Creates an empty map.
+     *
+     * @param capacity The initial capacity (rounded up to a power of two).
+     */
+    explicit ConcurrentHashMap(int capacity = CONCURRENT_MIN_CAPACITY) : _size(0)
+    {
+        int rounded = CONCURRENT_MIN_CAPACITY;
+        while (rounded < capacity)
+        {
+            rounded *= CHANGE_FACTOR;
+        }
+        _tables.emplace_back(new _Table(rounded));
+        _current.store(_tables.back().get());
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap &) = delete;
+
+    ConcurrentHashMap &operator=(const ConcurrentHashMap &) = delete;
+
+    /**
+     * Destructor for ConcurrentHashMap. No other thread may be using the map.
+     */
+    ~ConcurrentHashMap()
+    {
+        for (auto &table : _tables)
+        {
+            for (int i = 0; i < table->capacity; i++)
+            {
+                for (auto *pair : table->bins[i].row)
+                {
+                    delete pair;
+                }
+            }
+        }
+    }
+
+    /**
+     * Returns how many pairs there are (exact only while no other thread changes the map).
+     *
+     * @return How many pairs there are.
+     */
+    int size() const noexcept
+    {
+        return _size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the capacity of the current table (a migration to a larger one may be going on).
+     *
+     * @return The capacity of the current table.
+     */
+    int capacity() const noexcept
+    {
+        return _current.load(std::memory_order_acquire)->capacity;
+    }
+
+    /**
+     * Returns true if insertion to this map is successful. Otherwise returns false.
+     * Failure to insert happens when key already exists in this map.
+     *
+     * @param key The key to insert.
+     * @param value The value to insert.
+     * @return True if insertion to this map is successful. Otherwise returns false.
+     */
+    bool insert(const KeyT &key, const ValueT &value)
+    {
+        bool added = false;
+        _Table &table = _withBin(key, [&](HashRow &row)
+        {
+            if (_indexIn(row, key) < 0)
+            {
+                _addPair(row, key, value);
+                added = true;
+            }
+        });
+        if (added)
+        {
+            _added(table);
+        }
+        return added;
+    }
+
+    /**
+     * Pairs a key with a value, replacing its value if it is already in this map.
+     *
+     * @param key The key.
+     * @param value The value.
+     */
+    void put(const KeyT &key, const ValueT &value)
+    {
+        bool added = false;
+        _Table &table = _withBin(key, [&](HashRow &row)
+        {
+            int i = _indexIn(row, key);
+            if (i >= 0)
+            {
+                row[i]->second = value;
+                return;
+            }
+            _addPair(row, key, value);
+            added = true;
+        });
+        if (added)
+        {
+            _added(table);
+        }
+    }
+
+    /**
+     * Returns true if this map contains the given key. Otherwise, returns false.
+     *
+     * @param key The key to find.
+     * @return True if this map contains the given key. Otherwise, returns false.
+     */
+    bool containsKey(const KeyT &key)
+    {
+        bool found = false;
+        _withBin(key, [&](HashRow &row)
+        {
+            found = _indexIn(row, key) >= 0;
+        });
+        return found;
+    }
+
+    /**
+     * Copies the value paired with the given key, if it is in this map.
+     *
+     * @param key The key to find.
+     * @param value Set to the value paired with the key, if it is in this map.
+     * @return True if the key is in this map. Otherwise, returns false.
+     */
+    bool get(const KeyT &key, ValueT &value)
+    {
+        bool found = false;
+        _withBin(key, [&](HashRow &row)
+        {
+            int i = _indexIn(row, key);
+            if (i >= 0)
+            {
+                value = row[i]->second;
+                found = true;
+            }
+        });
+        return found;
+    }
+
+    /**
+     * Returns the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception.
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return A copy of the value paired with the given key.
+     */
+    ValueT at(const KeyT &key)
+    {
+        ValueT value;
+        if (!get(key, value))
+        {
+            throw KeyNotFoundException();
+        }
+        return value;
+    }
+
+    /**
+     * Returns true if the removal of the given key from this map is successful.
+     * Otherwise returns false.
+     *
+     * @param key The key to remove.
+     * @return True if the removal of the given key from this map is successful. Otherwise false.
+     */
+    bool erase(const KeyT &key)
+    {
+        std::pair<KeyT, ValueT> *erased = nullptr;
+        _withBin(key, [&](HashRow &row)
+        {
+            int i = _indexIn(row, key);
+            if (i >= 0)
+            {
+                erased = row[i];
+                row[i] = row.back();
+                row.pop_back();
+            }
+        });
+        if (erased == nullptr)
+        {
+            return false;
+        }
+        delete erased;
+        _size.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+#endif //SPAMDETECTOR_CONCURRENTHASHMAP_HPP
@@ -0,0 +1,126 @@
+/**
+ * @file ConcurrentStress.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Multi-threaded stress test of the ConcurrentHashMap, for running under sanitizers.
+ *
+ * @section DESCRIPTION
+ * This file runs threads that insert, read, overwrite and erase keys of their own while they read
+ * the keys of another thread, through many cooperative migrations of the table, and then checks
+ * every key and the size. "make stress" builds it with ThreadSanitizer and with AddressSanitizer
+ * and runs both, so that data races and memory errors fail the run as well as wrong results.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include "ConcurrentHashMap.hpp"
+
+#define USAGE_MSG "Usage: ConcurrentStress [threads] [keys per thread]"
+#define THREADS_INDEX 1
+#define KEYS_INDEX 2
+#define DEFAULT_THREADS 8
+#define DEFAULT_KEYS 40000
+#define ERASE_EVERY 3
+#define PUT_EVERY 5
+#define PUT_VALUE "put"
+
+typedef ConcurrentHashMap<long long, std::string> StressMap;
+
+// Returns true if the i-th key of a thread is in the map at the end.
+static bool present(int i)
+{
+    return i % ERASE_EVERY != 0 || i % PUT_EVERY == 0;
+}
+
+// Returns the value the i-th key of a thread has at the end (if it is present).
+static std::string finalValue(long long key, int i)
+{
+    return (i % PUT_EVERY == 0) ? PUT_VALUE : std::to_string(key);
+}
+
+// Runs the operations of one thread on its own keys, reading the keys of the next thread meanwhile.
+// Returns how many operations had a wrong result.
+static int stressThread(StressMap &map, int thread, int threads, int keys)
+{
+    int errors = 0;
+    for (int i = 0; i < keys; i++)
+    {
+        long long key = (long long) thread * keys + i;
+        std::string value;
+        errors += !map.insert(key, std::to_string(key));
+        errors += map.insert(key, PUT_VALUE);
+        errors += !map.get(key, value) || value != std::to_string(key);
+        if (i % ERASE_EVERY == 0)
+        {
+            errors += !map.erase(key);
+            errors += map.containsKey(key);
+        }
+        if (i % PUT_EVERY == 0)
+        {
+            map.put(key, PUT_VALUE);
+        }
+        map.containsKey((long long) ((thread + 1) % threads) * keys + i / 2);
+    }
+    return errors;
+}
+
+/**
+ * Program's main that receives an optional thread count and key count per thread, runs the stress
+ * test and checks the final contents of the map.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    int threads = (argc > THREADS_INDEX) ? std::atoi(argv[THREADS_INDEX]) : DEFAULT_THREADS;
+    int keys = (argc > KEYS_INDEX) ? std::atoi(argv[KEYS_INDEX]) : DEFAULT_KEYS;
+    if (argc > KEYS_INDEX + 1 || threads <= 0 || keys <= 0)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    StressMap map;
+    std::atomic<int> errors(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            errors += stressThread(map, t, threads, keys);
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    int expected = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        for (int i = 0; i < keys; i++)
+        {
+            long long key = (long long) t * keys + i;
+            std::string value;
+            bool found = map.get(key, value);
+            expected += present(i);
+            errors += found != present(i) || (found && value != finalValue(key, i));
+        }
+    }
+    errors += map.size() != expected;
+    if (errors != 0)
+    {
+        std::cerr << errors << " operations had wrong results." << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << threads << " threads: " << map.size() << " pairs, capacity " << map.capacity() << std::endl;
+    return EXIT_SUCCESS;
+}
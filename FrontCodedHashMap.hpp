@@ -0,0 +1,339 @@
+/**
+ * @file FrontCodedHashMap.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Read-mostly string-keyed map with prefix-compressed (front-coded) keys.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for a map from strings that is built once, for tables
+ * of many keys with long shared prefixes (phrases, URLs). The keys are sorted and front-coded in
+ * blocks of FRONT_CODED_BLOCK: the first key of every block is stored whole, and every other key
+ * as the length it shares with the first one and the rest of its bytes. An open-addressing table
+ * maps a 32-bit fingerprint of every key's hash to its rank, and a lookup verifies a candidate by
+ * skipping to it in its block and comparing it in place, without decoding any key into memory.
+ * Coding against the block's first key rather than the key before it compresses a little less,
+ * but verifying one key never depends on the keys between. The values are kept in an array by
+ * rank, and can be changed, but keys can't be added or erased.
+ */
+
+#ifndef SPAMDETECTOR_FRONTCODEDHASHMAP_HPP
+#define SPAMDETECTOR_FRONTCODEDHASHMAP_HPP
+
+#include <string>
+#include <cstring>
+#include "HashMap.hpp"
+
+#define FRONT_CODED_BLOCK 16
+#define FRONT_CODED_MAX_LOAD 0.8
+#define LENGTH_BITS 7
+#define LENGTH_MORE 0x80
+
+/**
+ * Map from strings to values, with the keys stored front-coded, for tables that are built once.
+ *
+ * @tparam ValueT The value type.
+ */
+template<typename ValueT>
+class FrontCodedHashMap
+{
+    // A table slot: the high half of a key's hash, and the key's rank plus one (0 if empty).
+    struct _Slot
+    {
+        unsigned int fingerprint, rank;
+    };
+
+    std::vector<unsigned char> _bytes;
+    std::vector<size_t> _blocks;
+    std::vector<ValueT> _values;
+    std::vector<_Slot> _slots;
+    int _size;
+
+    // Appends a length as a varint (7 bits per byte, low bits first).
+    void _putLength(size_t length)
+    {
+        for (; length >= LENGTH_MORE; length >>= LENGTH_BITS)
+        {
+            _bytes.push_back((unsigned char) (length | LENGTH_MORE));
+        }
+        _bytes.push_back((unsigned char) length);
+    }
+
+    // Reads a varint length and advances past it.
+    static size_t _getLength(const unsigned char *&bytes) noexcept
+    {
+        size_t length = 0;
+        for (int shift = 0;; shift += LENGTH_BITS)
+        {
+            unsigned char byte = *bytes++;
+            length |= (size_t) (byte & (LENGTH_MORE - 1)) << shift;
+            if (byte < LENGTH_MORE)
+            {
+                return length;
+            }
+        }
+    }
+
+    // Returns true if the key of a rank is the given key. Only the lengths of the keys before it
+    // in its block are read, to skip them; the key is compared with its block's first key up to
+    // the length they share, and then with its own bytes.
+    bool _keyIs(int rank, const std::string &key) const noexcept
+    {
+        const unsigned char *bytes = _bytes.data() + _blocks[rank / FRONT_CODED_BLOCK];
+        _getLength(bytes);
+        size_t length = _getLength(bytes);
+        const unsigned char *first = bytes;
+        for (int i = rank % FRONT_CODED_BLOCK; i > 0; i--)
+        {
+            bytes += length;
+            size_t shared = _getLength(bytes);
+            length = _getLength(bytes);
+            if (i == 1)
+            {
+                return shared + length == key.size() && std::memcmp(key.data(), first, shared) == 0 &&
+                       std::memcmp(key.data() + shared, bytes, length) == 0;
+            }
+        }
+        return length == key.size() && std::memcmp(key.data(), first, length) == 0;
+    }
+
+    // Returns the rank of a key, or -1 if it isn't in this map.
+    int _rank(const std::string &key) const noexcept
+    {
+        size_t hash = std::hash<std::string>{}(key), mask = _slots.size() - 1;
+        unsigned int fingerprint = (unsigned int) (hash >> 32);
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            const _Slot &slot = _slots[i];
+            if (slot.rank == 0)
+            {
+                return -1;
+            }
+            if (slot.fingerprint == fingerprint)
+            {
+                __builtin_prefetch(&_values[slot.rank - 1]); // Overlaps the value's miss with the key's.
+                if (_keyIs(slot.rank - 1, key))
+                {
+                    return slot.rank - 1;
+                }
+            }
+        }
+    }
+
+    // Builds this map from pairs sorted by key, with no equal keys.
+    void _build(const std::vector<std::pair<const std::string *, const ValueT *>> &sorted)
+    {
+        _size = sorted.size();
+        size_t capacity = 1;
+        while (capacity * FRONT_CODED_MAX_LOAD < _size)
+        {
+            capacity *= 2;
+        }
+        _slots.assign(capacity, {0, 0});
+        _values.reserve(_size);
+        _blocks.reserve((_size + FRONT_CODED_BLOCK - 1) / FRONT_CODED_BLOCK);
+
+        const std::string *first = nullptr;
+        for (int rank = 0; rank < _size; rank++)
+        {
+            const std::string &key = *sorted[rank].first;
+            size_t shared = 0;
+            if (rank % FRONT_CODED_BLOCK == 0)
+            {
+                _blocks.push_back(_bytes.size());
+                first = &key;
+            }
+            else
+            {
+                size_t most = std::min(key.size(), first->size());
+                while (shared < most && key[shared] == (*first)[shared])
+                {
+                    shared++;
+                }
+            }
+            _putLength(shared);
+            _putLength(key.size() - shared);
+            _bytes.insert(_bytes.end(), key.begin() + shared, key.end());
+            _values.push_back(*sorted[rank].second);
+
+            size_t hash = std::hash<std::string>{}(key), i = hash & (capacity - 1);
+            while (_slots[i].rank != 0)
+            {
+                i = (i + 1) & (capacity - 1);
+            }
+            _slots[i] = {(unsigned int) (hash >> 32), (unsigned int) rank + 1};
+        }
+        _bytes.shrink_to_fit();
+    }
+
+    // Sorts pairs by key, keeping only the last of equal keys.
+    static void _sortUnique(std::vector<std::pair<const std::string *, const ValueT *>> &pairs)
+    {
+        typedef std::pair<const std::string *, const ValueT *> Entry;
+        std::stable_sort(pairs.begin(), pairs.end(), [](const Entry &a, const Entry &b)
+        { return *a.first < *b.first; });
+        int kept = 0;
+        for (int i = 0; i < (int) pairs.size(); i++)
+        {
+            if (kept > 0 && *pairs[kept - 1].first == *pairs[i].first)
+            {
+                kept--;
+            }
+            pairs[kept++] = pairs[i];
+        }
+        pairs.resize(kept);
+    }
+
+public:
+    /**
+     * Creates an empty map.
+     */
+    FrontCodedHashMap() : _slots(1, {0, 0}), _size(0)
+    {}
+
+    /**
+     * Creates a map with the pairs of a HashMap.
+     *
+     * @param map The map to copy.
+     */
+    explicit FrontCodedHashMap(const HashMap<std::string, ValueT> &map)
+    {
+        std::vector<std::pair<const std::string *, const ValueT *>> pairs;
+        pairs.reserve(map.size());
+        for (const auto &pair : map)
+        {
+            pairs.emplace_back(&pair.first, &pair.second);
+        }
+        _sortUnique(pairs);
+        _build(pairs);
+    }
+
+    /**
+     * Creates a map from two vectors: one with keys and one with values.
+     * The mapping is done by the order of the vectors, and of equal keys, the last one is kept.
+     *
+     * @param keys A vector of keys.
+     * @param values A vector of values.
+     * @throws VectorInputException if vectors aren't of same size.
+     */
+    FrontCodedHashMap(const std::vector<std::string> &keys, const std::vector<ValueT> &values)
+    {
+        if (keys.size() != values.size())
+        {
+            throw VectorInputException();
+        }
+        std::vector<std::pair<const std::string *, const ValueT *>> pairs;
+        pairs.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            pairs.emplace_back(&keys[i], &values[i]);
+        }
+        _sortUnique(pairs);
+        _build(pairs);
+    }
+
+    /**
+     * Returns how many pairs there are.
+     *
+     * @return How many pairs there are.
+     */
+    int size() const noexcept
+    {
+        return _size;
+    }
+
+    /**
+     * Returns true if there are no pairs.
+     *
+     * @return True if there are no pairs.
+     */
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    /**
+     * Returns true if this map contains the given key. Otherwise, returns false.
+     *
+     * @param key The key to find.
+     * @return True if this map contains the given key. Otherwise, returns false.
+     */
+    bool containsKey(const std::string &key) const noexcept
+    {
+        return _rank(key) >= 0;
+    }
+
+    /**
+     * Returns the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception. (Const version)
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return The value paired with the given key.
+     */
+    const ValueT &at(const std::string &key) const
+    {
+        int rank = _rank(key);
+        if (rank < 0)
+        {
+            throw KeyNotFoundException();
+        }
+        return _values[rank];
+    }
+
+    /**
+     * Returns the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception. The value can be changed; the keys can't.
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return The value paired with the given key.
+     */
+    ValueT &at(const std::string &key)
+    {
+        int rank = _rank(key);
+        if (rank < 0)
+        {
+            throw KeyNotFoundException();
+        }
+        return _values[rank];
+    }
+
+    /**
+     * Calls a function with every pair, in the order of the keys, decoding every key once.
+     *
+     * @param function Called with every key (const std::string &) and value (const ValueT &).
+     */
+    template<typename Function>
+    void forEach(Function function) const
+    {
+        std::string first, key;
+        const unsigned char *bytes = _bytes.data();
+        for (int rank = 0; rank < _size; rank++)
+        {
+            size_t shared = _getLength(bytes), suffix = _getLength(bytes);
+            key.assign(first, 0, shared);
+            key.append((const char *) bytes, suffix);
+            bytes += suffix;
+            if (rank % FRONT_CODED_BLOCK == 0)
+            {
+                first = key;
+            }
+            function(static_cast<const std::string &>(key), _values[rank]);
+        }
+    }
+
+    /**
+     * Returns how many bytes this map holds on the heap, besides what its values hold themselves.
+     *
+     * @return How many bytes this map holds on the heap.
+     */
+    size_t heapBytes() const noexcept
+    {
+        return _bytes.capacity() + _blocks.capacity() * sizeof(size_t) + _values.capacity() * sizeof(ValueT) +
+               _slots.capacity() * sizeof(_Slot);
+    }
+};
+
+#endif //SPAMDETECTOR_FRONTCODEDHASHMAP_HPP
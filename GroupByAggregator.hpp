@@ -0,0 +1,651 @@
+/**
+ * @file GroupByAggregator.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Hash group-by aggregation (sum, count, min, max, avg) of key and value columns.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for a group-by aggregator. Groups live inline in flat,
+ * open-addressing tables, one per hash partition, so a new group costs no allocation of its own.
+ * Input is processed in batches whose slots are prefetched before they are updated. When the
+ * tables outgrow a memory budget, the largest partition is spilled to a temporary file as partial
+ * groups, and the partials are merged back when the groups are read. Large inputs can be
+ * aggregated by several threads into partial aggregators that are then merged in parallel, one
+ * partition per thread.
+ */
+
+#ifndef SPAMDETECTOR_GROUPBYAGGREGATOR_HPP
+#define SPAMDETECTOR_GROUPBYAGGREGATOR_HPP
+
+#include <tuple>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <exception>
+#include <cstdio>
+#include <unistd.h>
+#include "IntHashMap.hpp"
+#include "Serializer.hpp"
+
+#define PARTITION_BITS 4
+#define GROUP_PARTITIONS (1 << PARTITION_BITS)
+#define INITIAL_GROUP_CAPACITY 16
+#define SPILL_BUFFER_BYTES (1 << 20)
+#define DEFAULT_GROUP_BUDGET (256LL * 1024 * 1024)
+#define ERROR_AGGREGATE_SPILL "ERROR: GroupByAggregator failed to spill to or read a temporary file."
+
+/**
+ * Exception for failures to spill groups to, or to read them from, temporary files.
+ */
+class AggregationException : public HashMapException
+{
+public:
+    const char *what() const noexcept override
+    {
+        return ERROR_AGGREGATE_SPILL;
+    }
+};
+
+/**
+ * Sum of the values of a group.
+ */
+template<typename T>
+struct Sum
+{
+    T total = T();
+
+    void add(const T &value) noexcept
+    {
+        total += value;
+    }
+
+    void merge(const Sum &other) noexcept
+    {
+        total += other.total;
+    }
+
+    T result() const noexcept
+    {
+        return total;
+    }
+};
+
+/**
+ * Count of the values of a group.
+ */
+template<typename T>
+struct Count
+{
+    long long count = 0;
+
+    void add(const T &) noexcept
+    {
+        count++;
+    }
+
+    void merge(const Count &other) noexcept
+    {
+        count += other.count;
+    }
+
+    long long result() const noexcept
+    {
+        return count;
+    }
+};
+
+/**
+ * Minimum of the values of a group.
+ */
+template<typename T>
+struct Min
+{
+    T minimum = std::numeric_limits<T>::max();
+
+    void add(const T &value) noexcept
+    {
+        minimum = std::min(minimum, value);
+    }
+
+    void merge(const Min &other) noexcept
+    {
+        minimum = std::min(minimum, other.minimum);
+    }
+
+    T result() const noexcept
+    {
+        return minimum;
+    }
+};
+
+/**
+ * Maximum of the values of a group.
+ */
+template<typename T>
+struct Max
+{
+    T maximum = std::numeric_limits<T>::lowest();
+
+    void add(const T &value) noexcept
+    {
+        maximum = std::max(maximum, value);
+    }
+
+    void merge(const Max &other) noexcept
+    {
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    T result() const noexcept
+    {
+        return maximum;
+    }
+};
+
+/**
+ * Average of the values of a group.
+ */
+template<typename T>
+struct Avg
+{
+    T total = T();
+    long long count = 0;
+
+    void add(const T &value) noexcept
+    {
+        total += value;
+        count++;
+    }
+
+    void merge(const Avg &other) noexcept
+    {
+        total += other.total;
+        count += other.count;
+    }
+
+    double result() const noexcept
+    {
+        return count > 0 ? (double) total / count : 0;
+    }
+};
+
+/**
+ * Aggregates values by key, with several aggregates per group. For example,
+ * GroupByAggregator<std::string, long long, Sum, Count, Max> sums, counts and finds the maximum of
+ * the values of every key.
+ *
+ * @tparam KeyT The key type (with a Serializer, for spilling).
+ * @tparam ValueT The value type.
+ * @tparam Aggs The aggregates (templates over the value type, with add, merge and result, that are
+ * trivially copyable).
+ */
+template<typename KeyT, typename ValueT, template<typename> class... Aggs>
+class GroupByAggregator
+{
+public:
+    typedef std::tuple<Aggs<ValueT>...> State;
+
+private:
+    typedef std::index_sequence_for<Aggs<ValueT>...> _Indices;
+
+    // A slot of a table: a group, or empty if its tag is 0.
+    struct _Group
+    {
+        size_t tag = 0;
+        KeyT key;
+        State state;
+    };
+
+    // The groups of a partition in memory, and its spilled partial groups.
+    struct _Partition
+    {
+        std::vector<_Group> slots;
+        int size;
+        FILE *spill;
+    };
+
+    _Partition _partitions[GROUP_PARTITIONS];
+    long long _budget;
+
+    // Returns the partition of a hash.
+    static int _partitionOf(size_t hash) noexcept
+    {
+        return (int) (hash >> (sizeof(size_t) * 8 - PARTITION_BITS));
+    }
+
+    // Adds a value to every aggregate of a state.
+    template<size_t... I>
+    static void _add(State &state, const ValueT &value, std::index_sequence<I...>) noexcept
+    {
+        int expand[] = {0, (std::get<I>(state).add(value), 0)...};
+        (void) expand;
+    }
+
+    // Merges every aggregate of a state into another.
+    template<size_t... I>
+    static void _merge(State &state, const State &other, std::index_sequence<I...>) noexcept
+    {
+        int expand[] = {0, (std::get<I>(state).merge(std::get<I>(other)), 0)...};
+        (void) expand;
+    }
+
+    // Appends a state to a buffer.
+    template<size_t... I>
+    static void _write(std::string &out, const State &state, std::index_sequence<I...>)
+    {
+        int expand[] = {0, (Serializer<typename std::tuple_element<I, State>::type>::write(out, std::get<I>(state)), 0)...};
+        (void) expand;
+    }
+
+    // Reads a state from a buffer and advances it. Returns false if the buffer is too short.
+    template<size_t... I>
+    static bool _read(const char *&in, const char *end, State &state, std::index_sequence<I...>)
+    {
+        bool read = true;
+        int expand[] = {0, (read = read && Serializer<typename std::tuple_element<I, State>::type>::read(
+                in, end, std::get<I>(state)), 0)...};
+        (void) expand;
+        return read;
+    }
+
+    // Returns the state of the key's group in a table, creating the group if there's none.
+    static State &_find(std::vector<_Group> &slots, int &size, const KeyT &key, size_t hash)
+    {
+        if (size + 1 > slots.size() * MAX_LOAD_FACTOR)
+        {
+            std::vector<_Group> grown(slots.size() * CHANGE_FACTOR);
+            for (_Group &group : slots)
+            {
+                if (group.tag != 0)
+                {
+                    size_t mask = grown.size() - 1, i = group.tag & mask;
+                    while (grown[i].tag != 0)
+                    {
+                        i = (i + 1) & mask;
+                    }
+                    grown[i] = std::move(group);
+                }
+            }
+            slots.swap(grown);
+        }
+
+        size_t tag = hash | 1, mask = slots.size() - 1, i = tag & mask;
+        while (slots[i].tag != 0)
+        {
+            if (slots[i].tag == tag && slots[i].key == key)
+            {
+                return slots[i].state;
+            }
+            i = (i + 1) & mask;
+        }
+        slots[i].tag = tag;
+        slots[i].key = key;
+        size++;
+        return slots[i].state;
+    }
+
+    // Returns how many bytes the tables hold.
+    long long _bytes() const noexcept
+    {
+        long long slots = 0;
+        for (const _Partition &partition : _partitions)
+        {
+            slots += partition.slots.size();
+        }
+        return slots * (long long) sizeof(_Group);
+    }
+
+    // Writes the groups of a partition to its temporary file and empties it in memory.
+    void _spill(_Partition &partition)
+    {
+        if (partition.spill == nullptr && (partition.spill = std::tmpfile()) == nullptr)
+        {
+            throw AggregationException();
+        }
+        std::string buffer;
+        for (const _Group &group : partition.slots)
+        {
+            if (group.tag != 0)
+            {
+                Serializer<size_t>::write(buffer, group.tag);
+                Serializer<KeyT>::write(buffer, group.key);
+                _write(buffer, group.state, _Indices());
+            }
+            if (buffer.size() >= SPILL_BUFFER_BYTES || &group == &partition.slots.back())
+            {
+                if (std::fwrite(buffer.data(), 1, buffer.size(), partition.spill) != buffer.size())
+                {
+                    throw AggregationException();
+                }
+                buffer.clear();
+            }
+        }
+        if (std::fflush(partition.spill) != 0)
+        {
+            throw AggregationException();
+        }
+        std::vector<_Group>(INITIAL_GROUP_CAPACITY).swap(partition.slots);
+        partition.size = 0;
+    }
+
+    // Spills the largest partitions until the tables fit in the budget.
+    void _enforceBudget()
+    {
+        while (_bytes() > _budget)
+        {
+            _Partition *largest = &_partitions[0];
+            for (_Partition &partition : _partitions)
+            {
+                largest = (partition.size > largest->size) ? &partition : largest;
+            }
+            if (largest->size == 0)
+            {
+                return;
+            }
+            _spill(*largest);
+        }
+    }
+
+    // Calls function(tag, key, state) with every partial group of a partition: the spilled ones, then those in memory.
+    template<typename Function>
+    void _forEachPartial(const _Partition &partition, Function function) const
+    {
+        if (partition.spill != nullptr)
+        {
+            // Read the file in chunks; a group cut by the end of a chunk is kept for the next one.
+            int fd = fileno(partition.spill);
+            std::string data;
+            off_t offset = 0;
+            size_t tag;
+            KeyT key;
+            State state;
+            while (true)
+            {
+                size_t kept = data.size();
+                data.resize(kept + SPILL_BUFFER_BYTES);
+                ssize_t got = pread(fd, &data[kept], SPILL_BUFFER_BYTES, offset);
+                if (got < 0)
+                {
+                    throw AggregationException();
+                }
+                data.resize(kept + got);
+                offset += got;
+
+                const char *in = data.data(), *end = in + data.size(), *group = in;
+                while (group < end && Serializer<size_t>::read(in, end, tag) && Serializer<KeyT>::read(in, end, key) &&
+                       _read(in, end, state, _Indices()))
+                {
+                    function(tag, key, state);
+                    group = in;
+                }
+                data.erase(0, group - data.data());
+                if (got == 0)
+                {
+                    if (!data.empty()) // The file ends inside a group.
+                    {
+                        throw AggregationException();
+                    }
+                    break;
+                }
+            }
+        }
+        for (const _Group &group : partition.slots)
+        {
+            if (group.tag != 0)
+            {
+                function(group.tag, group.key, group.state);
+            }
+        }
+    }
+
+    // Merges the partial groups of another aggregator's partition into this one's, without spilling.
+    void _mergePartition(int index, const GroupByAggregator &other)
+    {
+        _Partition &partition = _partitions[index];
+        other._forEachPartial(other._partitions[index], [&](size_t tag, const KeyT &key, const State &state)
+        {
+            _merge(_find(partition.slots, partition.size, key, tag), state, _Indices());
+        });
+    }
+
+public:
+    /**
+     * Creates an empty aggregator.
+     *
+     * @param budget How many bytes of groups to keep in memory before spilling.
+     */
+    explicit GroupByAggregator(long long budget = DEFAULT_GROUP_BUDGET) : _budget(budget)
+    {
+        for (_Partition &partition : _partitions)
+        {
+            partition.slots.resize(INITIAL_GROUP_CAPACITY);
+            partition.size = 0;
+            partition.spill = nullptr;
+        }
+    }
+
+    GroupByAggregator(const GroupByAggregator &other) = delete;
+
+    GroupByAggregator &operator=(const GroupByAggregator &other) = delete;
+
+    /**
+     * Destroys the aggregator and its temporary files.
+     */
+    ~GroupByAggregator()
+    {
+        for (_Partition &partition : _partitions)
+        {
+            if (partition.spill != nullptr)
+            {
+                std::fclose(partition.spill);
+            }
+        }
+    }
+
+    /**
+     * Adds a value to the group of a key.
+     *
+     * @param key The key.
+     * @param value The value.
+     * @throws AggregationException if spilling fails.
+     */
+    void add(const KeyT &key, const ValueT &value)
+    {
+        size_t hash = mixInt(std::hash<KeyT>{}(key)); // Random low (slot) and high (partition) bits.
+        _Partition &partition = _partitions[_partitionOf(hash)];
+        size_t capacity = partition.slots.size();
+        _add(_find(partition.slots, partition.size, key, hash), value, _Indices());
+        if (partition.slots.size() != capacity)
+        {
+            _enforceBudget();
+        }
+    }
+
+    /**
+     * Adds columns of keys and values, prefetching the slots of up to PROBE_BATCH rows before
+     * updating them.
+     *
+     * @param keys The keys.
+     * @param values The values (values[i] belongs to keys[i]).
+     * @param count How many rows there are.
+     * @throws AggregationException if spilling fails.
+     */
+    void addBatch(const KeyT *keys, const ValueT *values, int count)
+    {
+        size_t hashes[PROBE_BATCH];
+        for (int start = 0; start < count; start += PROBE_BATCH)
+        {
+            int batch = std::min(PROBE_BATCH, count - start);
+            for (int i = 0; i < batch; i++)
+            {
+                hashes[i] = mixInt(std::hash<KeyT>{}(keys[start + i]));
+                const std::vector<_Group> &slots = _partitions[_partitionOf(hashes[i])].slots;
+                __builtin_prefetch(&slots[(hashes[i] | 1) & (slots.size() - 1)]);
+            }
+            bool grown = false;
+            for (int i = 0; i < batch; i++)
+            {
+                _Partition &partition = _partitions[_partitionOf(hashes[i])];
+                size_t capacity = partition.slots.size();
+                _add(_find(partition.slots, partition.size, keys[start + i], hashes[i]), values[start + i], _Indices());
+                grown = grown || partition.slots.size() != capacity;
+            }
+            if (grown)
+            {
+                _enforceBudget();
+            }
+        }
+    }
+
+    /**
+     * Adds columns of keys and values from several threads: each aggregates a slice of the rows
+     * into a partial aggregator (with an equal share of the budget), and then each merges a
+     * share of the partitions of all partials into this aggregator. The budget is enforced once
+     * the merge is done.
+     *
+     * @param keys The keys.
+     * @param values The values (values[i] belongs to keys[i]).
+     * @param count How many rows there are.
+     * @param threads How many threads to use.
+     * @throws AggregationException if spilling fails.
+     */
+    void addParallel(const KeyT *keys, const ValueT *values, int count, int threads)
+    {
+        threads = std::max(1, std::min(threads, GROUP_PARTITIONS));
+        std::vector<std::unique_ptr<GroupByAggregator>> partials;
+        for (int t = 0; t < threads; t++)
+        {
+            partials.emplace_back(new GroupByAggregator(_budget / threads));
+        }
+        std::vector<std::exception_ptr> errors(threads);
+        auto run = [&](std::function<void(int)> work)
+        {
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; t++)
+            {
+                workers.emplace_back([&, t]()
+                {
+                    try
+                    {
+                        work(t);
+                    }
+                    catch (...)
+                    {
+                        errors[t] = std::current_exception();
+                    }
+                });
+            }
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+            for (std::exception_ptr &error : errors)
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+
+        run([&](int t)
+        {
+            int first = (int) ((long long) count * t / threads), last = (int) ((long long) count * (t + 1) / threads);
+            partials[t]->addBatch(keys + first, values + first, last - first);
+        });
+        run([&](int t)
+        {
+            for (int index = t; index < GROUP_PARTITIONS; index += threads)
+            {
+                for (auto &partial : partials)
+                {
+                    _mergePartition(index, *partial);
+                }
+            }
+        });
+        _enforceBudget();
+    }
+
+    /**
+     * Merges the groups of another aggregator into this one.
+     *
+     * @param other The other aggregator.
+     * @throws AggregationException if spilling or reading the other's spilled groups fails.
+     */
+    void merge(const GroupByAggregator &other)
+    {
+        for (int index = 0; index < GROUP_PARTITIONS; index++)
+        {
+            _mergePartition(index, other);
+            _enforceBudget();
+        }
+    }
+
+    /**
+     * Returns true if some groups were spilled to temporary files.
+     *
+     * @return True if some groups were spilled.
+     */
+    bool spilled() const noexcept
+    {
+        for (const _Partition &partition : _partitions)
+        {
+            if (partition.spill != nullptr)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Calls a function with every group, one partition at a time. The partial groups of a spilled
+     * partition are merged in a temporary table first, so reading needs memory for the groups of
+     * the largest partition.
+     *
+     * @param function Called with the key (const KeyT &) and the state (const State &) of every
+     * group; std::get<i>(state).result() is the result of the i-th aggregate.
+     * @throws AggregationException if reading spilled groups fails.
+     */
+    template<typename Function>
+    void forEachGroup(Function function) const
+    {
+        for (const _Partition &partition : _partitions)
+        {
+            if (partition.spill == nullptr)
+            {
+                for (const _Group &group : partition.slots)
+                {
+                    if (group.tag != 0)
+                    {
+                        function(group.key, group.state);
+                    }
+                }
+                continue;
+            }
+
+            std::vector<_Group> merged(INITIAL_GROUP_CAPACITY);
+            int size = 0;
+            _forEachPartial(partition, [&](size_t tag, const KeyT &key, const State &state)
+            {
+                _merge(_find(merged, size, key, tag), state, _Indices());
+            });
+            for (const _Group &group : merged)
+            {
+                if (group.tag != 0)
+                {
+                    function(group.key, group.state);
+                }
+            }
+        }
+    }
+};
+
+#endif //SPAMDETECTOR_GROUPBYAGGREGATOR_HPP
@@ -0,0 +1,130 @@
+/**
+ * @file HashJoin.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Hash-join of a stream of records against a HashMap.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for joining records (the probe side) against a
+ * HashMap (the build side) by a key taken from every record. The records are probed PROBE_BATCH
+ * at a time with HashMap::findBatch, so their cache misses overlap, and misses are reported as
+ * values, never as exceptions. Inner, left outer, semi and anti joins are supported, with the
+ * results going to a callback or appended to a buffer.
+ */
+
+#ifndef SPAMDETECTOR_HASHJOIN_HPP
+#define SPAMDETECTOR_HASHJOIN_HPP
+
+#include "HashMap.hpp"
+
+/**
+ * The kinds of joins.
+ */
+enum JoinMode
+{
+    INNER_JOIN, // Every record with a match, with its value.
+    LEFT_OUTER_JOIN, // Every record, with its value or nullptr.
+    SEMI_JOIN, // Every record with a match (the value is passed too).
+    ANTI_JOIN // Every record without a match (with nullptr).
+};
+
+/*
+ * Private helper function that joins records against a HashMap, PROBE_BATCH at a time, and
+ * calls emit with the iterator of every record that the mode keeps and its value (or nullptr).
+ */
+template<typename KeyT, typename ValueT, typename Iterator, typename KeyOf, typename Emit>
+static long long _joinBatches(const HashMap<KeyT, ValueT> &build, Iterator first, Iterator last, KeyOf &keyOf,
+                              JoinMode mode, Emit emit)
+{
+    Iterator records[PROBE_BATCH];
+    const KeyT *keys[PROBE_BATCH] = {};
+    const ValueT *values[PROBE_BATCH] = {};
+    long long emitted = 0;
+    while (first != last)
+    {
+        int count = 0;
+        for (; count < PROBE_BATCH && first != last; ++first, count++)
+        {
+            records[count] = first;
+            keys[count] = &keyOf(*first);
+        }
+        build.findBatch(keys, count, values);
+        for (int i = 0; i < count; i++)
+        {
+            bool matched = values[i] != nullptr;
+            if (mode == LEFT_OUTER_JOIN || matched == (mode != ANTI_JOIN))
+            {
+                emit(records[i], values[i]);
+                emitted++;
+            }
+        }
+    }
+    return emitted;
+}
+
+/**
+ * Joins records against a HashMap and calls output with every record that the mode keeps, in
+ * the records' order. Inner and semi joins keep the same records; they differ only in intent.
+ *
+ * @param build The map to join against.
+ * @param first The first record.
+ * @param last The end of the records (a forward iterator).
+ * @param keyOf Returns a reference to the key (const KeyT &) of a record.
+ * @param mode The kind of join.
+ * @param output Called with every kept record and a pointer to its value in build (or nullptr).
+ * @return How many records were output.
+ */
+template<typename KeyT, typename ValueT, typename Iterator, typename KeyOf, typename Output>
+long long hashJoin(const HashMap<KeyT, ValueT> &build, Iterator first, Iterator last, KeyOf keyOf, JoinMode mode,
+                   Output output)
+{
+    return _joinBatches(build, first, last, keyOf, mode, [&output](const Iterator &record, const ValueT *value)
+    {
+        output(*record, value);
+    });
+}
+
+/**
+ * Joins records that are themselves keys against a HashMap (see above).
+ *
+ * @param build The map to join against.
+ * @param first The first key.
+ * @param last The end of the keys (a forward iterator).
+ * @param mode The kind of join.
+ * @param output Called with every kept key and a pointer to its value in build (or nullptr).
+ * @return How many keys were output.
+ */
+template<typename KeyT, typename ValueT, typename Iterator, typename Output>
+long long hashJoin(const HashMap<KeyT, ValueT> &build, Iterator first, Iterator last, JoinMode mode, Output output)
+{
+    return hashJoin(build, first, last, [](const KeyT &key) -> const KeyT &
+    {
+        return key;
+    }, mode, output);
+}
+
+/**
+ * Joins records against a HashMap and appends every record that the mode keeps to a buffer, as
+ * its iterator and a pointer to its value in build (or nullptr).
+ *
+ * @param build The map to join against.
+ * @param first The first record.
+ * @param last The end of the records (a forward iterator).
+ * @param keyOf Returns a reference to the key (const KeyT &) of a record.
+ * @param mode The kind of join.
+ * @param buffer The buffer to append to.
+ * @return How many records were appended.
+ */
+template<typename KeyT, typename ValueT, typename Iterator, typename KeyOf>
+long long hashJoinInto(const HashMap<KeyT, ValueT> &build, Iterator first, Iterator last, KeyOf keyOf,
+                       JoinMode mode, std::vector<std::pair<Iterator, const ValueT *>> &buffer)
+{
+    return _joinBatches(build, first, last, keyOf, mode, [&buffer](const Iterator &record, const ValueT *value)
+    {
+        buffer.emplace_back(record, value);
+    });
+}
+
+#endif //SPAMDETECTOR_HASHJOIN_HPP
@@ -15,11 +15,28 @@
 
 #include <vector>
 #include <list>
+#include <new>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "HashMapTrace.hpp"
+#include "LatencySampler.hpp"
+#include "BatchHasher.hpp"
 
 #define DEFAULT_SIZE 0
 #define DEFAULT_CAPACITY 16
 #define MIN_CAPACITY 1
 #define CHANGE_FACTOR 2
+#define NODE_POOL_SIZE 256
+#define RESERVE_MIN_CAPACITY (1 << 16)
+#define RESERVED_CAPACITY (1 << 28)
+#define PROBE_BATCH 16
+#define DEFAULT_FRONT_CACHE_SLOTS 2048
+#define FRONT_CACHE_MULTIPLIER 0x9e3779b97f4a7c15ULL
+#define HIT_SKETCH_ROWS 4
+#define HIT_SKETCH_WIDTH 1024
 #define ERROR_VECTOR_INPUT "ERROR: HashMap should receive 2 valid vectors of equal size."
 #define ERROR_KEY_NOT_FOUND "ERROR: HashMap key not found."
 #define ERROR_OUT_OF_RANGE "ERROR: Attempting to use HashMap iterator outside of range."
@@ -72,9 +89,24 @@ class OutOfRangeException : public HashMapException
     }
 };
 
+/**
+ * How a HashMap orders the pairs in its buckets (see HashMap::setBucketOrder).
+ */
+enum BucketOrder
+{
+    UNORDERED_BUCKETS, // No order; erasing swaps the last pair of the bucket into the gap.
+    COUNT_HITS, // Hits are counted for reorganize(), and erasing keeps the order.
+    TRANSPOSE_ON_HIT, // As COUNT_HITS, and a hit swaps the pair with the one before it.
+    MOVE_TO_FRONT_ON_HIT // As COUNT_HITS, and a hit moves the pair to the front of its bucket.
+};
+
 /**
  * Generic map class that uses open-hashing.
  *
+ * From RESERVE_MIN_CAPACITY buckets on, the bucket array lives in an address range reserved for
+ * RESERVED_CAPACITY buckets (touched only as it is used), so that rehashing grows and shrinks it in
+ * place instead of allocating a second array.
+ *
  * @tparam KeyT The key type.
  * @tparam ValueT The value type.
  */
@@ -83,6 +115,13 @@ class HashMap
 {
     typedef std::vector<std::pair<KeyT, ValueT> *> HashRow;
 
+    // A front cache slot: a recently found pair and its key's full hash.
+    struct _FrontSlot
+    {
+        size_t hash;
+        std::pair<KeyT, ValueT> *pair;
+    };
+
     // The hashing function.
     int _hash(const KeyT &key) const noexcept
     {
@@ -92,12 +131,105 @@ class HashMap
     // Copies another HashMap into this one.
     void _copy(const HashMap &other) noexcept;
 
-    // Rehashes this map.
+    // Returns rows for the given capacity: in a reserved range when it's large, setting reserved to
+    // the rows the range holds, or else in an array, setting reserved to 0. Throws std::bad_alloc.
+    static HashRow *_allocateRows(int capacity, size_t &reserved);
+
+    // Destroys and frees rows returned by _allocateRows.
+    static void _freeRows(HashRow *rows, int capacity, size_t reserved) noexcept;
+
+    // Rehashes this map into a new array of buckets, moving the rows of the old one.
     void _rehashArray(int newCapacity) noexcept;
 
+    // Returns the rows of a rehash to the given capacity (this map's own when they fit in its reserved
+    // range), or nullptr (reported) if it can't get them. Sets reserved as _allocateRows does.
+    HashRow *_allocateRehash(int newCapacity, size_t &reserved) noexcept;
+
+    // Returns the row whose buffer becomes bucket j of a rehash into the given rows (see _moveRows).
+    HashRow &_rehashTarget(HashRow *rows, int j) const noexcept
+    {
+        return (j < _capacity) ? _arr[j] : rows[j];
+    }
+
+    // Moves every pair into the rows of a rehash and frees the old ones, tracing it.
+    void _moveRows(HashRow *rows, int newCapacity, size_t reserved) noexcept;
+
+    // Frees the rows of a rehash that won't happen.
+    void _abandonRehash(HashRow *rows, int newCapacity, size_t reserved) noexcept;
+
+    // Returns a new pair, reusing the storage of an erased pair when there is one.
+    std::pair<KeyT, ValueT> *_newPair(const KeyT &key, const ValueT &value);
+
+    // Destroys a pair and keeps its storage for reuse (up to NODE_POOL_SIZE pairs).
+    void _releasePair(std::pair<KeyT, ValueT> *pair) noexcept;
+
+    // Reverses the bits of a hash, so that sorting by it groups by bucket for every capacity.
+    static size_t _reverseBits(size_t hash) noexcept;
+
+    // Returns the bucket of a key, reporting it when it is longer than the probe limit.
+    HashRow &_row(const KeyT &key) const noexcept
+    {
+        return _rowOf(std::hash<KeyT>{}(key));
+    }
+
+    // Returns the bucket of a key's full hash (see _row).
+    HashRow &_rowOf(size_t hash) const noexcept
+    {
+        int index = hash & (_capacity - 1);
+        HashRow &row = _arr[index];
+        if ((int) row.size() > _probeLimit)
+        {
+            _reportLongProbe(index, (int) row.size());
+        }
+        return row;
+    }
+
+    // Returns a pointer to the value of a key, or nullptr, through the front cache and bucket order.
+    ValueT *_find(const KeyT &key) const noexcept;
+
+    // Finds a key through the front cache and reorders its bucket on a hit, whichever are on.
+    ValueT *_findAdaptive(const KeyT &key) const noexcept;
+
+    // Counts a hit of a full hash in the sketch, and moves the pair at index j of its row forward.
+    void _organize(size_t hash, HashRow &row, int j) const noexcept;
+
+    // Returns the estimated hit count of a full hash (the least of its sketch counters).
+    unsigned int _hitCount(size_t hash) const noexcept;
+
+    // Returns the front cache slot of a full hash.
+    _FrontSlot &_frontSlot(size_t hash) const noexcept
+    {
+        return _front[(size_t) ((hash * FRONT_CACHE_MULTIPLIER) >> 32) & (_front.size() - 1)];
+    }
+
+    // Forgets a pair that is about to be erased, if the front cache holds it.
+    void _forget(size_t hash, const std::pair<KeyT, ValueT> *pair) const noexcept
+    {
+        if (!_front.empty() && _frontSlot(hash).pair == pair)
+        {
+            _frontSlot(hash) = {0, nullptr};
+        }
+    }
+
+    // Reports a lookup in a bucket longer than the probe limit.
+    void _reportLongProbe(int bucket, int length) const noexcept;
+
+    // Reports a failed allocation of the given number of bytes.
+    void _reportAllocationFailure(size_t bytes) const noexcept;
+
     int _size, _capacity;
     ValueT _defaultValue;
     HashRow *_arr;
+    size_t _reservedRows = 0;
+    std::vector<void *> _pool;
+    HashMapObserver *_observer = nullptr;
+    int _probeLimit = DEFAULT_PROBE_LIMIT;
+    LatencySampler *_sampler = nullptr;
+    mutable std::vector<_FrontSlot> _front;
+    BucketOrder _order = UNORDERED_BUCKETS;
+    int _organizePeriod = 1;
+    mutable unsigned int _organizeRandom = 0x9e3779b9u;
+    mutable std::vector<unsigned int> _hits;
 
 public:
     // Constructors and destructors.
@@ -130,6 +262,32 @@ public:
     ~HashMap() noexcept;
 
     // Inner classes.
+    /**
+     * An operation of a batch: an insertion of a pair or an erasure of a key.
+     */
+    struct BatchOp
+    {
+        bool erase;
+        KeyT key;
+        ValueT value;
+
+        /**
+         * Returns an operation that inserts the given pair.
+         */
+        static BatchOp insert(const KeyT &key, const ValueT &value)
+        {
+            return BatchOp{false, key, value};
+        }
+
+        /**
+         * Returns an operation that erases the given key.
+         */
+        static BatchOp remove(const KeyT &key)
+        {
+            return BatchOp{true, key, ValueT()};
+        }
+    };
+
     /**
      * const forward iterator class for HashMap.
      */
@@ -137,6 +295,7 @@ public:
     {
         int _i, _j, _capacity;
         HashRow *_arr;
+        LatencySampler *_sampler;
 
 
     public:
@@ -153,8 +312,10 @@ public:
          * @param arr The HashMaps array.
          * @param capacity The HashMaps capacity.
          * @param begin if true then starts at start. Otherwise at end of iterator.
+         * @param sampler The HashMaps latency sampler, or nullptr.
          */
-        explicit const_iterator(HashRow *arr, int capacity, bool begin = true) noexcept;
+        explicit const_iterator(HashRow *arr, int capacity, bool begin = true,
+                                LatencySampler *sampler = nullptr) noexcept;
 
         /**
          * Copy constructor for iterator.
@@ -162,7 +323,7 @@ public:
          * @param other The iterator to copy.
          */
         const_iterator(const const_iterator &other) noexcept : _i(other._i), _j(other._j), _capacity(other._capacity),
-                                                               _arr(other._arr) {}
+                                                               _arr(other._arr), _sampler(other._sampler) {}
 
         /**
          * -> operator for iterator.
@@ -300,6 +461,37 @@ public:
      */
     ValueT &at(const KeyT &key);
 
+    /**
+     * Finds a batch of keys. The buckets, rows and first pairs of up to PROBE_BATCH keys are
+     * prefetched before any of them is compared, so the cache misses of the keys overlap instead
+     * of following each other.
+     *
+     * @param keys Pointers to the keys to find.
+     * @param count How many keys there are.
+     * @param values For every key, a pointer to its value in this map, or nullptr if it isn't in it.
+     */
+    void findBatch(const KeyT *const *keys, int count, const ValueT **values) const noexcept;
+
+    /**
+     * Calls a function with every pair in a range of buckets. Disjoint ranges can be visited by
+     * different threads at the same time, as long as nothing changes the map.
+     *
+     * @param first The first bucket of the range.
+     * @param last The bucket after the range (at most capacity()).
+     * @param function Called with every pair (const std::pair<KeyT, ValueT> &) in the range.
+     */
+    template<typename Function>
+    void forEachInBuckets(int first, int last, Function function) const
+    {
+        for (int i = first; i < last; i++)
+        {
+            for (auto *pair : _arr[i])
+            {
+                function(*pair);
+            }
+        }
+    }
+
     /**
      * Returns true if given key was found in this map and erases it. Otherwise, returns false.
      *
@@ -308,6 +500,17 @@ public:
      */
     bool erase(const KeyT &key) noexcept;
 
+    /**
+     * Applies a batch of insertions and erasures, with the same result (and capacity) as calling
+     * insert() and erase() in order, but rehashing at most once and visiting the buckets in order.
+     * Either every operation is applied or, if an exception is thrown, none is.
+     *
+     * @param ops The operations, in order.
+     * @throws std::bad_alloc (or what copying keys and values throws), leaving this map unchanged.
+     * @return How many operations changed this map (insertions of new keys and erasures of present ones).
+     */
+    int applyBatch(const std::vector<BatchOp> &ops);
+
     /**
      * Returns this map's load factor.
      *
@@ -343,6 +546,79 @@ public:
      */
     void clear() noexcept;
 
+    /**
+     * Sets the observer that is told about this map's rehashes, long probes and failed
+     * allocations (see HashMapTrace.hpp). The observer isn't copied with the map.
+     *
+     * @param observer The observer, or nullptr for none. It must outlive its use by this map.
+     * @param probeLimit Lookups in buckets longer than this are reported as long probes.
+     */
+    void setObserver(HashMapObserver *observer, int probeLimit = DEFAULT_PROBE_LIMIT) noexcept
+    {
+        _observer = observer;
+        _probeLimit = probeLimit;
+    }
+
+    /**
+     * Turns on a small direct-mapped cache in front of the buckets for containsKey(), at() and
+     * operator[]. Every slot keeps a recently found pair with its key's full hash, so a hot key is
+     * found with one probe of the cache and one comparison, without going through its bucket.
+     * Erasing a key drops it from the cache; rehashing doesn't, since pairs never move. The cache
+     * isn't copied with the map. While it's on, these lookups write to the cache even on a const
+     * map, so threads mustn't share the map without a lock.
+     *
+     * @param slots How many slots to use (rounded up to a power of two), or 0 to turn the cache off.
+     */
+    void setFrontCache(int slots = DEFAULT_FRONT_CACHE_SLOTS)
+    {
+        int rounded = 1;
+        while (rounded < slots)
+        {
+            rounded *= 2;
+        }
+        _front.assign((slots > 0) ? rounded : 0, {0, nullptr});
+    }
+
+    /**
+     * Sets how the pairs in every bucket are ordered, for lookups of skewed keys in long buckets.
+     * With any order but UNORDERED_BUCKETS, containsKey(), at() and operator[] count hits in a
+     * small sketch for reorganize(), may move the found pair toward the front of its bucket, and
+     * erasing keeps the order of the rest of the bucket. Like the front cache, this makes those
+     * lookups write even on a const map, and moving pairs under an iterator may make it skip or
+     * repeat pairs. The order isn't copied with the map.
+     *
+     * @param order The order.
+     * @param period A hit is counted and moves its pair with probability 1 / period, to limit
+     * the writes of hot lookups.
+     */
+    void setBucketOrder(BucketOrder order, int period = 1)
+    {
+        _order = order;
+        _organizePeriod = std::max(1, period);
+        _hits.assign((order == UNORDERED_BUCKETS) ? 0 : HIT_SKETCH_ROWS * HIT_SKETCH_WIDTH, 0);
+    }
+
+    /**
+     * Sorts every bucket by the counted hits of its keys, most hit first, and then halves the
+     * counts so that they follow changes in popularity. Does nothing without counted hits (see
+     * setBucketOrder).
+     *
+     * @throws std::bad_alloc, leaving the buckets that weren't sorted yet as they were.
+     */
+    void reorganize();
+
+    /**
+     * Sets the sampler that times about one in N of this map's finds (containsKey, at and
+     * operator[]), insertions, erasures and iterator steps (see LatencySampler.hpp). The sampler
+     * isn't copied with the map, and iterators keep the sampler of when they were created.
+     *
+     * @param sampler The sampler, or nullptr for none. It must outlive its use by this map.
+     */
+    void setSampler(LatencySampler *sampler) noexcept
+    {
+        _sampler = sampler;
+    }
+
     /**
      * Returns starting iterator for this map.
      *
@@ -350,7 +626,7 @@ public:
      */
     const_iterator begin() const
     {
-        return const_iterator(_arr, _capacity);
+        return const_iterator(_arr, _capacity, true, _sampler);
     }
 
     /**
@@ -370,7 +646,7 @@ public:
      */
     const_iterator cbegin() const noexcept
     {
-        return const_iterator(_arr, _capacity);
+        return const_iterator(_arr, _capacity, true, _sampler);
     }
 
     /**
@@ -448,26 +724,32 @@ static ValueT *_getValue(const KeyT &key, const std::vector<std::pair<KeyT, Valu
 }
 
 /*
- * Private helper function that returns true if a key is in this row and deletes it.
- * Otherwise, returns false.
+ * Private helper function that removes the pair with the given key from this row and returns it.
+ * Otherwise, returns nullptr. (The caller owns the returned pair)
  */
 template<typename KeyT, typename ValueT>
-static bool _deleteValue(const KeyT &key, std::vector<std::pair<KeyT, ValueT> *> &row) noexcept
+static std::pair<KeyT, ValueT> *_removeValue(const KeyT &key, std::vector<std::pair<KeyT, ValueT> *> &row,
+                                            bool keepOrder = false) noexcept
 {
     for (auto it = row.begin(); it != row.end(); ++it)
     {
         if ((*it)->first == key)
         {
-            delete (*it);
+            auto *pair = *it;
+            if (keepOrder)
+            {
+                row.erase(it);
+                return pair;
+            }
             if (row.back() != *it) // swap with back then pop for O(1) erase.
             {
                 std::swap(row.back(), *it);
             }
             row.pop_back();
-            return true;
+            return pair;
         }
     }
-    return false;
+    return nullptr;
 }
 
 // Private helper function that copies another map into this one.
@@ -476,34 +758,361 @@ void HashMap<KeyT, ValueT>::_copy(const HashMap &other) noexcept
 {
     _size = other._size;
     _capacity = other._capacity;
-    _arr = new std::vector<std::pair<KeyT, ValueT> *>[_capacity];
+    _arr = _allocateRows(_capacity, _reservedRows);
     for (int i = 0; i < _capacity; i++)
     {
         auto &thisRow = _arr[i], &otherRow = other._arr[i];
         for (auto *pair : otherRow)
         {
-            thisRow.push_back(new std::pair<KeyT, ValueT>(*pair));
+            thisRow.push_back(_newPair(pair->first, pair->second));
         }
     }
 }
 
-// Private method that rehashes this map.
+// Private method that rehashes this map, keeping the old capacity if it can't allocate.
 template<typename KeyT, typename ValueT>
 void HashMap<KeyT, ValueT>::_rehashArray(int newCapacity) noexcept
 {
-    auto *temp = new std::vector<std::pair<KeyT, ValueT> *>[newCapacity];
+    // A rehash that can't get its table doesn't start, so it isn't reported as started.
+    size_t reserved;
+    HashRow *rows = _allocateRehash(newCapacity, reserved);
+    if (rows != nullptr)
+    {
+        _moveRows(rows, newCapacity, reserved);
+    }
+}
+
+// Private helper function that allocates rows, reserving room to grow for large capacities.
+template<typename KeyT, typename ValueT>
+typename HashMap<KeyT, ValueT>::HashRow *HashMap<KeyT, ValueT>::_allocateRows(int capacity, size_t &reserved)
+{
+    reserved = 0;
+    if (capacity >= RESERVE_MIN_CAPACITY)
+    {
+        // The pages of the range are only backed once they are touched, so the reservation costs
+        // address space and not memory. Without one, the rows go in an array as for small maps.
+        size_t rows = std::max(capacity, RESERVED_CAPACITY);
+        void *range = mmap(nullptr, rows * sizeof(HashRow), PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (range != MAP_FAILED)
+        {
+            auto *arr = static_cast<HashRow *>(range);
+            for (int i = 0; i < capacity; i++)
+            {
+                new(arr + i) HashRow();
+            }
+            reserved = rows;
+            return arr;
+        }
+    }
+    return new HashRow[capacity];
+}
+
+// Private helper function that destroys and frees rows.
+template<typename KeyT, typename ValueT>
+void HashMap<KeyT, ValueT>::_freeRows(HashRow *rows, int capacity, size_t reserved) noexcept
+{
+    if (reserved == 0)
+    {
+        delete[] rows;
+        return;
+    }
+    for (int i = 0; i < capacity; i++)
+    {
+        rows[i].~HashRow();
+    }
+    munmap(rows, reserved * sizeof(HashRow));
+}
+
+// Private helper function that allocates the rows of a rehash, in place when they fit.
+template<typename KeyT, typename ValueT>
+typename HashMap<KeyT, ValueT>::HashRow *
+HashMap<KeyT, ValueT>::_allocateRehash(int newCapacity, size_t &reserved) noexcept
+{
+    if ((size_t) newCapacity <= _reservedRows)
+    {
+        for (int i = _capacity; i < newCapacity; i++)
+        {
+            new(_arr + i) HashRow();
+        }
+        reserved = _reservedRows;
+        return _arr;
+    }
+    try
+    {
+        return _allocateRows(newCapacity, reserved);
+    }
+    catch (const std::bad_alloc &)
+    {
+        _reportAllocationFailure(newCapacity * sizeof(HashRow));
+        return nullptr;
+    }
+}
+
+// Private helper function that frees the rows of an abandoned rehash.
+template<typename KeyT, typename ValueT>
+void HashMap<KeyT, ValueT>::_abandonRehash(HashRow *rows, int newCapacity, size_t reserved) noexcept
+{
+    if (rows != _arr)
+    {
+        _freeRows(rows, newCapacity, reserved);
+        return;
+    }
+    for (int i = _capacity; i < newCapacity; i++)
+    {
+        _arr[i].~HashRow();
+    }
+}
+
+// Private method that moves the rows of this map into those of a rehash. It allocates only for rows
+// that didn't reserve room for their pairs (see applyBatch).
+template<typename KeyT, typename ValueT>
+void HashMap<KeyT, ValueT>::_moveRows(HashRow *rows, int newCapacity, size_t reserved) noexcept
+{
+    int oldCapacity = _capacity;
+    auto start = std::chrono::steady_clock::now();
+    HASHMAP_PROBE3(rehash_start, this, oldCapacity, newCapacity);
+    if (_observer != nullptr)
+    {
+        _observer->rehashStarted(this, oldCapacity, newCapacity);
+    }
+
+    // Every row's buffer moves to its new bucket instead of being copied, so the pairs are never
+    // in two sets of rows at once. Growing, a row keeps the pairs that stay in bucket i (in order)
+    // and hands the others (those with a new hash bit set) to buckets above the old capacity.
+    // Shrinking, the rows that fold into one bucket are appended to it. In place, the rows below
+    // the smaller capacity are already where they belong.
     for (int i = 0; i < _capacity; i++)
     {
-        auto &row = _arr[i];
-        for (auto *pair : row)
+        auto &row = rows[i & (newCapacity - 1)];
+        if (&row != &_arr[i] && row.empty())
         {
-            temp[(std::hash<KeyT>{}(pair->first) & (newCapacity - 1))].push_back(pair);
+            row.swap(_arr[i]);
+        }
+        else if (&row != &_arr[i])
+        {
+            row.insert(row.end(), _arr[i].begin(), _arr[i].end());
+            HashRow().swap(_arr[i]);
+        }
+        if (newCapacity > _capacity)
+        {
+            int kept = 0;
+            for (auto *pair : row)
+            {
+                int index = std::hash<KeyT>{}(pair->first) & (newCapacity - 1);
+                if (index == i)
+                {
+                    row[kept++] = pair;
+                }
+                else
+                {
+                    rows[index].push_back(pair);
+                }
+            }
+            if (kept == 0)
+            {
+                HashRow().swap(row); // Don't hold a buffer for an empty bucket.
+            }
+            row.resize(kept);
+        }
+    }
+    if (rows != _arr)
+    {
+        _freeRows(_arr, _capacity, _reservedRows);
+        _arr = rows;
+        _reservedRows = reserved;
+    }
+    else if (newCapacity < _capacity)
+    {
+        // Give the pages of the rows that are gone back, keeping the range reserved.
+        for (int i = newCapacity; i < _capacity; i++)
+        {
+            _arr[i].~HashRow();
+        }
+        uintptr_t page = sysconf(_SC_PAGESIZE);
+        uintptr_t first = ((uintptr_t) (_arr + newCapacity) + page - 1) & ~(page - 1);
+        uintptr_t last = ((uintptr_t) (_arr + _capacity) + page - 1) & ~(page - 1);
+        if (first < last)
+        {
+            madvise((void *) first, last - first, MADV_DONTNEED);
         }
-        row.clear();
     }
-    delete[] _arr;
-    _arr = temp;
     _capacity = newCapacity;
+
+    long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    HASHMAP_PROBE4(rehash_end, this, oldCapacity, newCapacity, nanoseconds);
+    if (_observer != nullptr)
+    {
+        _observer->rehashFinished(this, oldCapacity, newCapacity, nanoseconds);
+    }
+}
+
+// Private helper function that returns a new pair, reusing pooled storage when there is some.
+template<typename KeyT, typename ValueT>
+std::pair<KeyT, ValueT> *HashMap<KeyT, ValueT>::_newPair(const KeyT &key, const ValueT &value)
+{
+    if (_pool.empty())
+    {
+        try
+        {
+            return new std::pair<KeyT, ValueT>(key, value);
+        }
+        catch (std::bad_alloc &)
+        {
+            _reportAllocationFailure(sizeof(std::pair<KeyT, ValueT>));
+            throw;
+        }
+    }
+
+    auto *pair = new(_pool.back()) std::pair<KeyT, ValueT>(key, value);
+    _pool.pop_back();
+    return pair;
+}
+
+// Private helper function that destroys a pair and pools its storage for the next insertion.
+template<typename KeyT, typename ValueT>
+void HashMap<KeyT, ValueT>::_releasePair(std::pair<KeyT, ValueT> *pair) noexcept
+{
+    if ((int) _pool.size() < NODE_POOL_SIZE)
+    {
+        if (_pool.capacity() == 0)
+        {
+            try
+            {
+                _pool.reserve(NODE_POOL_SIZE); // Once, so that pooling never reallocates.
+            }
+            catch (std::bad_alloc &) // No pool then; the pair is just freed.
+            {
+                _reportAllocationFailure(NODE_POOL_SIZE * sizeof(void *));
+                delete pair;
+                return;
+            }
+        }
+        pair->~pair();
+        _pool.push_back(pair);
+    }
+    else
+    {
+        delete pair;
+    }
+}
+
+// Private helper function that finds a key, through the front cache and bucket order if they're on.
+template<typename KeyT, typename ValueT>
+ValueT *HashMap<KeyT, ValueT>::_find(const KeyT &key) const noexcept
+{
+    if (_front.empty() && _order == UNORDERED_BUCKETS)
+    {
+        return _getValue(key, _row(key));
+    }
+    return _findAdaptive(key);
+}
+
+// Private helper function that finds a key through the front cache and self-organizing buckets.
+template<typename KeyT, typename ValueT>
+ValueT *HashMap<KeyT, ValueT>::_findAdaptive(const KeyT &key) const noexcept
+{
+    size_t hash = std::hash<KeyT>{}(key);
+    _FrontSlot *slot = _front.empty() ? nullptr : &_frontSlot(hash);
+    if (slot != nullptr && slot->hash == hash && slot->pair != nullptr && slot->pair->first == key)
+    {
+        return &slot->pair->second;
+    }
+    HashRow &row = _rowOf(hash);
+    for (int j = 0; j < (int) row.size(); j++)
+    {
+        auto *pair = row[j];
+        if (pair->first == key)
+        {
+            if (slot != nullptr)
+            {
+                *slot = {hash, pair};
+            }
+            if (_order != UNORDERED_BUCKETS)
+            {
+                _organize(hash, row, j);
+            }
+            return &pair->second;
+        }
+    }
+    return nullptr;
+}
+
+// Private helper function that counts a hit and moves its pair forward, one in every period hits.
+template<typename KeyT, typename ValueT>
+void HashMap<KeyT, ValueT>::_organize(size_t hash, HashRow &row, int j) const noexcept
+{
+    if (_organizePeriod > 1)
+    {
+        _organizeRandom ^= _organizeRandom << 13; // xorshift32.
+        _organizeRandom ^= _organizeRandom >> 17;
+        _organizeRandom ^= _organizeRandom << 5;
+        if (_organizeRandom % _organizePeriod != 0)
+        {
+            return;
+        }
+    }
+    size_t mixed = hash * FRONT_CACHE_MULTIPLIER;
+    for (int i = 0; i < HIT_SKETCH_ROWS; i++, mixed = (mixed >> 16) | (mixed << 48))
+    {
+        unsigned int &counter = _hits[i * HIT_SKETCH_WIDTH + (mixed & (HIT_SKETCH_WIDTH - 1))];
+        counter += (counter != ~0u);
+    }
+    if (j > 0 && _order == TRANSPOSE_ON_HIT)
+    {
+        std::swap(row[j - 1], row[j]);
+    }
+    else if (j > 0 && _order == MOVE_TO_FRONT_ON_HIT)
+    {
+        std::rotate(row.begin(), row.begin() + j, row.begin() + j + 1);
+    }
+}
+
+// Private helper function that estimates the hits of a full hash from the sketch.
+template<typename KeyT, typename ValueT>
+unsigned int HashMap<KeyT, ValueT>::_hitCount(size_t hash) const noexcept
+{
+    unsigned int count = ~0u;
+    size_t mixed = hash * FRONT_CACHE_MULTIPLIER;
+    for (int i = 0; i < HIT_SKETCH_ROWS; i++, mixed = (mixed >> 16) | (mixed << 48))
+    {
+        count = std::min(count, _hits[i * HIT_SKETCH_WIDTH + (mixed & (HIT_SKETCH_WIDTH - 1))]);
+    }
+    return count;
+}
+
+// Private helper function that fires the long probe tracepoint and observer callback.
+template<typename KeyT, typename ValueT>
+void HashMap<KeyT, ValueT>::_reportLongProbe(int bucket, int length) const noexcept
+{
+    HASHMAP_PROBE3(long_probe, this, bucket, length);
+    if (_observer != nullptr)
+    {
+        _observer->longProbe(this, bucket, length);
+    }
+}
+
+// Private helper function that fires the allocation failure tracepoint and observer callback.
+template<typename KeyT, typename ValueT>
+void HashMap<KeyT, ValueT>::_reportAllocationFailure(size_t bytes) const noexcept
+{
+    HASHMAP_PROBE2(allocation_failure, this, bytes);
+    if (_observer != nullptr)
+    {
+        _observer->allocationFailed(this, bytes);
+    }
+}
+
+// Private helper function that reverses the bits of a hash.
+template<typename KeyT, typename ValueT>
+size_t HashMap<KeyT, ValueT>::_reverseBits(size_t hash) noexcept
+{
+    static_assert(sizeof(size_t) == sizeof(unsigned long long), "Reverses 64-bit hashes.");
+    hash = ((hash >> 1) & 0x5555555555555555ULL) | ((hash & 0x5555555555555555ULL) << 1);
+    hash = ((hash >> 2) & 0x3333333333333333ULL) | ((hash & 0x3333333333333333ULL) << 2);
+    hash = ((hash >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((hash & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    return __builtin_bswap64(hash);
 }
 
 /**
@@ -512,7 +1121,7 @@ void HashMap<KeyT, ValueT>::_rehashArray(int newCapacity) noexcept
 template<typename KeyT, typename ValueT>
 HashMap<KeyT, ValueT>::HashMap() noexcept : _size(DEFAULT_SIZE), _capacity(DEFAULT_CAPACITY)
 {
-    _arr = new std::vector<std::pair<KeyT, ValueT> *>[DEFAULT_CAPACITY];
+    _arr = _allocateRows(DEFAULT_CAPACITY, _reservedRows);
 }
 
 /**
@@ -536,13 +1145,27 @@ HashMap<KeyT, ValueT>::HashMap(const std::vector<KeyT> &keys, const std::vector<
     while (_capacity <= _size || getLoadFactor() > MAX_LOAD_FACTOR)
     { _capacity *= 2; }
 
-    _arr = new std::vector<std::pair<KeyT, ValueT> *>[_capacity];
-    for (int i = 0; i < _size; i++)
+    _arr = _allocateRows(_capacity, _reservedRows);
+    const KeyT *batch[PROBE_BATCH];
+    size_t hashes[PROBE_BATCH];
+    int total = keys.size(); // _size shrinks with every duplicate.
+    for (int i = 0; i < total; i++)
     {
+        if (i % PROBE_BATCH == 0) // Hash the next batch of keys together.
+        {
+            int count = std::min(PROBE_BATCH, total - i);
+            for (int j = 0; j < count; j++)
+            {
+                batch[j] = &keys[i + j];
+            }
+            BatchHash<KeyT>::hash(batch, count, hashes);
+        }
         auto *pair = new std::pair<KeyT, ValueT>(keys[i], values[i]);
-        auto &row = _arr[_hash(pair->first)];
-        if (_deleteValue(pair->first, row)) // If duplicate keys then remove pair and adjust size.
+        auto &row = _arr[hashes[i % PROBE_BATCH] & (_capacity - 1)];
+        auto *duplicate = _removeValue(pair->first, row);
+        if (duplicate != nullptr) // If duplicate keys then remove pair and adjust size.
         {
+            delete duplicate;
             _size--;
         }
         row.push_back(pair);
@@ -568,7 +1191,11 @@ template<typename KeyT, typename ValueT>
 HashMap<KeyT, ValueT>::~HashMap() noexcept
 {
     clear();
-    delete[] _arr;
+    _freeRows(_arr, _capacity, _reservedRows);
+    for (void *storage : _pool)
+    {
+        ::operator delete(storage);
+    }
 }
 
 /**
@@ -582,13 +1209,14 @@ HashMap<KeyT, ValueT>::~HashMap() noexcept
 template<typename KeyT, typename ValueT>
 bool HashMap<KeyT, ValueT>::insert(const KeyT &key, const ValueT &value) noexcept
 {
-    auto &row = _arr[_hash(key)];
+    SampleTimer timer(_sampler, SAMPLED_INSERT);
+    auto &row = _row(key);
     if (_getValue(key, row) != nullptr)
     {
         return false;
     }
 
-    row.push_back(new std::pair<KeyT, ValueT>(key, value));
+    row.push_back(_newPair(key, value));
     _size++;
     if (getLoadFactor() > MAX_LOAD_FACTOR)
     {
@@ -606,7 +1234,8 @@ bool HashMap<KeyT, ValueT>::insert(const KeyT &key, const ValueT &value) noexcep
 template<typename KeyT, typename ValueT>
 bool HashMap<KeyT, ValueT>::containsKey(const KeyT &key) const noexcept
 {
-    return _getValue(key, _arr[_hash(key)]) != nullptr;
+    SampleTimer timer(_sampler, SAMPLED_FIND);
+    return _find(key) != nullptr;
 }
 
 /**
@@ -620,7 +1249,8 @@ bool HashMap<KeyT, ValueT>::containsKey(const KeyT &key) const noexcept
 template<typename KeyT, typename ValueT>
 const ValueT &HashMap<KeyT, ValueT>::at(const KeyT &key) const
 {
-    ValueT *value = _getValue(key, _arr[_hash(key)]);
+    SampleTimer timer(_sampler, SAMPLED_FIND);
+    ValueT *value = _find(key);
     if (value != nullptr)
     {
         return *value;
@@ -639,7 +1269,8 @@ const ValueT &HashMap<KeyT, ValueT>::at(const KeyT &key) const
 template<typename KeyT, typename ValueT>
 ValueT &HashMap<KeyT, ValueT>::at(const KeyT &key)
 {
-    ValueT *value = _getValue(key, _arr[_hash(key)]);
+    SampleTimer timer(_sampler, SAMPLED_FIND);
+    ValueT *value = _find(key);
     if (value != nullptr)
     {
         return *value;
@@ -657,7 +1288,8 @@ ValueT &HashMap<KeyT, ValueT>::at(const KeyT &key)
 template<typename KeyT, typename ValueT>
 const ValueT &HashMap<KeyT, ValueT>::operator[](const KeyT &key) const noexcept
 {
-    ValueT *value = _getValue(key, _arr[_hash(key)]);
+    SampleTimer timer(_sampler, SAMPLED_FIND);
+    ValueT *value = _find(key);
     if (value != nullptr)
     {
         return *value;
@@ -675,13 +1307,14 @@ const ValueT &HashMap<KeyT, ValueT>::operator[](const KeyT &key) const noexcept
 template<typename KeyT, typename ValueT>
 ValueT &HashMap<KeyT, ValueT>::operator[](const KeyT &key) noexcept
 {
-    ValueT *value = _getValue(key, _arr[_hash(key)]);
+    SampleTimer timer(_sampler, SAMPLED_FIND); // Counted as a find even when it inserts.
+    ValueT *value = _find(key);
     if (value != nullptr)
     {
         return *value;
     }
 
-    auto *pair = new std::pair<KeyT, ValueT>(key, ValueT());
+    auto *pair = _newPair(key, ValueT());
     _arr[_hash(key)].push_back(pair);
     _size++;
     if (getLoadFactor() > MAX_LOAD_FACTOR)
@@ -691,6 +1324,51 @@ ValueT &HashMap<KeyT, ValueT>::operator[](const KeyT &key) noexcept
     return pair->second;
 }
 
+/**
+ * Finds a batch of keys, prefetching each stage of the lookups of up to PROBE_BATCH keys before
+ * the next one needs it.
+ *
+ * @param keys Pointers to the keys to find.
+ * @param count How many keys there are.
+ * @param values For every key, a pointer to its value in this map, or nullptr if it isn't in it.
+ */
+template<typename KeyT, typename ValueT>
+void HashMap<KeyT, ValueT>::findBatch(const KeyT *const *keys, int count, const ValueT **values) const noexcept
+{
+    int indices[PROBE_BATCH];
+    size_t hashes[PROBE_BATCH];
+    for (int start = 0; start < count; start += PROBE_BATCH)
+    {
+        int batch = std::min(PROBE_BATCH, count - start);
+        BatchHash<KeyT>::hash(keys + start, batch, hashes);
+        for (int i = 0; i < batch; i++)
+        {
+            indices[i] = hashes[i] & (_capacity - 1);
+            __builtin_prefetch(&_arr[indices[i]]);
+        }
+        for (int i = 0; i < batch; i++)
+        {
+            __builtin_prefetch(_arr[indices[i]].data());
+        }
+        for (int i = 0; i < batch; i++)
+        {
+            if (!_arr[indices[i]].empty())
+            {
+                __builtin_prefetch(_arr[indices[i]][0]);
+            }
+        }
+        for (int i = 0; i < batch; i++)
+        {
+            HashRow &row = _arr[indices[i]];
+            if ((int) row.size() > _probeLimit)
+            {
+                _reportLongProbe(indices[i], (int) row.size());
+            }
+            values[start + i] = _getValue(*keys[start + i], row);
+        }
+    }
+}
+
 /**
  * Returns true if given key was found in this map and erases it. Otherwise, returns false.
  *
@@ -700,8 +1378,13 @@ ValueT &HashMap<KeyT, ValueT>::operator[](const KeyT &key) noexcept
 template<typename KeyT, typename ValueT>
 bool HashMap<KeyT, ValueT>::erase(const KeyT &key) noexcept
 {
-    if (_deleteValue(key, _arr[_hash(key)]))
+    SampleTimer timer(_sampler, SAMPLED_ERASE);
+    size_t hash = std::hash<KeyT>{}(key);
+    auto *pair = _removeValue(key, _rowOf(hash), _order != UNORDERED_BUCKETS);
+    if (pair != nullptr)
     {
+        _forget(hash, pair);
+        _releasePair(pair);
         _size--;
         if ((getLoadFactor() < MIN_LOAD_FACTOR) && (_capacity > MIN_CAPACITY))
         {
@@ -712,6 +1395,189 @@ bool HashMap<KeyT, ValueT>::erase(const KeyT &key) noexcept
     return false;
 }
 
+/**
+ * Applies a batch of insertions and erasures, with the same result (and capacity) as calling
+ * insert() and erase() in order, but rehashing at most once and visiting the buckets in order.
+ * Either every operation is applied or, if an exception is thrown, none is.
+ *
+ * @param ops The operations, in order.
+ * @throws std::bad_alloc (or what copying keys and values throws), leaving this map unchanged.
+ * @return How many operations changed this map (insertions of new keys and erasures of present ones).
+ */
+template<typename KeyT, typename ValueT>
+int HashMap<KeyT, ValueT>::applyBatch(const std::vector<BatchOp> &ops)
+{
+    // Sorting by reversed hash keeps every bucket contiguous whatever the capacity, and a stable
+    // sort keeps the operations on each key in their order.
+    int count = ops.size();
+    std::vector<size_t> hashes(count), reversed(count);
+    std::vector<int> order(count);
+    std::vector<char> effective(count);
+    const KeyT *batch[PROBE_BATCH];
+    for (int start = 0; start < count; start += PROBE_BATCH)
+    {
+        int size = std::min(PROBE_BATCH, count - start);
+        for (int i = 0; i < size; i++)
+        {
+            batch[i] = &ops[start + i].key;
+        }
+        BatchHash<KeyT>::hash(batch, size, &hashes[start]);
+    }
+    for (int i = 0; i < count; i++)
+    {
+        reversed[i] = _reverseBits(hashes[i]);
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&reversed](int a, int b)
+    { return reversed[a] < reversed[b]; });
+
+    // Find which operations take effect, without changing anything. Equal keys have equal hashes,
+    // so only operations in the same run of equal hashes can affect each other.
+    int newSize = _size, applied = 0, inserted = 0;
+    std::vector<std::pair<const KeyT *, bool>> present;
+    for (int start = 0, end; start < count; start = end)
+    {
+        present.clear();
+        for (end = start; end < count && hashes[order[end]] == hashes[order[start]]; end++)
+        {
+            const BatchOp &op = ops[order[end]];
+            auto it = std::find_if(present.begin(), present.end(), [&op](const std::pair<const KeyT *, bool> &p)
+            { return *p.first == op.key; });
+            if (it == present.end())
+            {
+                present.emplace_back(&op.key, _getValue(op.key, _arr[hashes[order[end]] & (_capacity - 1)]) != nullptr);
+                it = present.end() - 1;
+            }
+            if (it->second == op.erase)
+            {
+                effective[order[end]] = true;
+                it->second = !op.erase;
+                newSize += op.erase ? -1 : 1;
+                inserted += !op.erase;
+                applied++;
+            }
+        }
+    }
+
+    if (applied == 0)
+    {
+        return 0;
+    }
+
+    // Resize to the capacity that insert() and erase() would end with: replay their growing and
+    // shrinking over the operations that take effect, in their order.
+    int newCapacity = _capacity, replayedSize = _size;
+    for (int i = 0; i < count; i++)
+    {
+        if (!effective[i])
+        {
+            continue;
+        }
+        replayedSize += ops[i].erase ? -1 : 1;
+        if (!ops[i].erase && (double) replayedSize / newCapacity > MAX_LOAD_FACTOR)
+        {
+            newCapacity *= CHANGE_FACTOR;
+        }
+        else if (ops[i].erase && (double) replayedSize / newCapacity < MIN_LOAD_FACTOR && newCapacity > MIN_CAPACITY)
+        {
+            newCapacity /= CHANGE_FACTOR;
+        }
+    }
+
+    // Allocate everything up front: the new pairs, the pool, room in every row they go to and, if
+    // the capacity changes, the new rows with room for every pair that moves to them.
+    std::vector<std::pair<KeyT, ValueT> *> fresh;
+    HashRow *rows = nullptr;
+    size_t reserved = 0;
+    try
+    {
+        fresh.reserve(inserted);
+        _pool.reserve(NODE_POOL_SIZE);
+        for (int i : order)
+        {
+            if (effective[i] && !ops[i].erase)
+            {
+                fresh.push_back(_newPair(ops[i].key, ops[i].value));
+            }
+        }
+
+        // The rows that get new pairs are contiguous in the order.
+        for (int start = 0, end; start < count; start = end)
+        {
+            int bucket = hashes[order[start]] & (_capacity - 1), added = 0;
+            for (end = start; end < count && (int) (hashes[order[end]] & (_capacity - 1)) == bucket; end++)
+            {
+                added += effective[order[end]] && !ops[order[end]].erase;
+            }
+            _arr[bucket].reserve(_arr[bucket].size() + added);
+        }
+
+        if (newCapacity != _capacity)
+        {
+            std::vector<int> counts(newCapacity);
+            for (int i = 0; i < _capacity; i++)
+            {
+                for (auto *pair : _arr[i])
+                {
+                    counts[std::hash<KeyT>{}(pair->first) & (newCapacity - 1)]++;
+                }
+            }
+            for (int i : order)
+            {
+                counts[hashes[i] & (newCapacity - 1)] += effective[i] && !ops[i].erase;
+            }
+            rows = _allocateRehash(newCapacity, reserved);
+            if (rows == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            for (int j = 0; j < newCapacity; j++)
+            {
+                _rehashTarget(rows, j).reserve(counts[j]);
+            }
+        }
+    }
+    catch (...)
+    {
+        if (rows != nullptr)
+        {
+            _abandonRehash(rows, newCapacity, reserved);
+        }
+        for (auto *pair : fresh)
+        {
+            _releasePair(pair);
+        }
+        throw;
+    }
+
+    // Nothing below allocates or throws: the operations apply at the current capacity, and then the
+    // rows move to the new one within the room reserved for them.
+    auto next = fresh.begin();
+    for (int i : order)
+    {
+        if (effective[i])
+        {
+            auto &row = _arr[hashes[i] & (_capacity - 1)];
+            if (ops[i].erase)
+            {
+                auto *pair = _removeValue(ops[i].key, row, _order != UNORDERED_BUCKETS);
+                _forget(hashes[i], pair);
+                _releasePair(pair);
+            }
+            else
+            {
+                row.push_back(*next++);
+            }
+        }
+    }
+    _size = newSize;
+    if (rows != nullptr)
+    {
+        _moveRows(rows, newCapacity, reserved);
+    }
+    return applied;
+}
+
 /**
  * Returns the size of the bucket which contains the given key, if it is in this map.
  * Otherwise, throws exception.
@@ -750,6 +1616,47 @@ int HashMap<KeyT, ValueT>::bucketIndex(const KeyT &key) const
     throw KeyNotFoundException();
 }
 
+/**
+ * Sorts every bucket by the counted hits of its keys, most hit first, and then halves the
+ * counts so that they follow changes in popularity. Does nothing without counted hits (see
+ * setBucketOrder).
+ *
+ * @throws std::bad_alloc, leaving the buckets that weren't sorted yet as they were.
+ */
+template<typename KeyT, typename ValueT>
+void HashMap<KeyT, ValueT>::reorganize()
+{
+    if (_hits.empty())
+    {
+        return;
+    }
+    typedef std::pair<unsigned int, std::pair<KeyT, ValueT> *> Counted;
+    std::vector<Counted> counted;
+    for (int i = 0; i < _capacity; i++)
+    {
+        HashRow &row = _arr[i];
+        if (row.size() < 2)
+        {
+            continue;
+        }
+        counted.clear();
+        for (auto *pair : row)
+        {
+            counted.emplace_back(_hitCount(std::hash<KeyT>{}(pair->first)), pair);
+        }
+        std::stable_sort(counted.begin(), counted.end(), [](const Counted &a, const Counted &b)
+        { return a.first > b.first; });
+        for (int j = 0; j < (int) row.size(); j++)
+        {
+            row[j] = counted[j].second;
+        }
+    }
+    for (unsigned int &counter : _hits)
+    {
+        counter /= 2;
+    }
+}
+
 /**
  * Clears this map from all elements, while not changing the capacity.
  */
@@ -761,10 +1668,11 @@ void HashMap<KeyT, ValueT>::clear() noexcept
         auto &row = _arr[i];
         for (auto *pair : row)
         {
-            delete pair;
+            _releasePair(pair);
         }
         row.clear();
     }
+    std::fill(_front.begin(), _front.end(), _FrontSlot{0, nullptr});
     _size = 0;
 }
 
@@ -780,7 +1688,7 @@ HashMap<KeyT, ValueT> &HashMap<KeyT, ValueT>::operator=(const HashMap<KeyT, Valu
     if (_arr != other._arr) // if not same object.
     {
         clear();
-        delete[] _arr;
+        _freeRows(_arr, _capacity, _reservedRows);
         _copy(other);
     }
     return *this;
@@ -822,8 +1730,9 @@ bool HashMap<KeyT, ValueT>::operator==(const HashMap &other) const noexcept
  * @param begin if true then starts at start. Otherwise at end of iterator.
  */
 template<typename KeyT, typename ValueT>
-HashMap<KeyT, ValueT>::const_iterator::const_iterator(HashRow *arr, int capacity, bool begin) noexcept :
-        _j(0), _capacity(capacity), _arr(arr)
+HashMap<KeyT, ValueT>::const_iterator::const_iterator(HashRow *arr, int capacity, bool begin,
+                                                      LatencySampler *sampler) noexcept :
+        _j(0), _capacity(capacity), _arr(arr), _sampler(sampler)
 {
     if (begin)
     {
@@ -861,6 +1770,7 @@ template<typename KeyT, typename ValueT>
 typename HashMap<KeyT, ValueT>::const_iterator &
 HashMap<KeyT, ValueT>::const_iterator::operator++() noexcept
 {
+    SampleTimer timer(_sampler, SAMPLED_ITERATE);
     if (_i < _capacity)
     {
         if (++_j >= (int)_arr[_i].size())
@@ -903,6 +1813,7 @@ HashMap<KeyT, ValueT>::const_iterator::operator=(
         _i = other._i;
         _j = other._j;
         _capacity = other._capacity;
+        _sampler = other._sampler;
     }
     return *this;
 }
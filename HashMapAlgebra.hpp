@@ -0,0 +1,359 @@
+/**
+ * @file HashMapAlgebra.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Set algebra between HashMaps: intersection, union, difference and symmetric difference.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for set operations on the keys of two HashMaps, both
+ * into a new map and in place. Every operation iterates the smaller map wherever the result
+ * allows it, and finds its keys in the larger one with batched, prefetching probes
+ * (HashMap::findBatch). The probing can be split over threads by bucket ranges. When a key is in
+ * both maps, the result keeps the value of the first (left) map.
+ */
+
+#ifndef SPAMDETECTOR_HASHMAPALGEBRA_HPP
+#define SPAMDETECTOR_HASHMAPALGEBRA_HPP
+
+#include <thread>
+#include "HashMap.hpp"
+
+#define MIN_BUCKETS_PER_THREAD 4096
+
+/*
+ * Private helper function that finds the keys of the pairs in a range of buckets of source in
+ * target, PROBE_BATCH at a time, and calls sink with every pair and its key's value in target
+ * (or nullptr).
+ */
+template<typename KeyT, typename ValueT, typename Sink>
+static void _probeBuckets(const HashMap<KeyT, ValueT> &source, const HashMap<KeyT, ValueT> &target,
+                          int first, int last, Sink &sink)
+{
+    const std::pair<KeyT, ValueT> *pairs[PROBE_BATCH] = {};
+    const KeyT *keys[PROBE_BATCH] = {};
+    const ValueT *values[PROBE_BATCH] = {};
+    int count = 0;
+    auto flush = [&]()
+    {
+        target.findBatch(keys, count, values);
+        for (int i = 0; i < count; i++)
+        {
+            sink(*pairs[i], values[i]);
+        }
+        count = 0;
+    };
+    source.forEachInBuckets(first, last, [&](const std::pair<KeyT, ValueT> &pair)
+    {
+        pairs[count] = &pair;
+        keys[count] = &pair.first;
+        if (++count == PROBE_BATCH)
+        {
+            flush();
+        }
+    });
+    flush();
+}
+
+/*
+ * Private helper function that calls sink with every pair of source and its key's value in
+ * target (or nullptr). With more than one thread, the buckets of source are split between them,
+ * and sink is called afterwards, from the calling thread. Neither map may change meanwhile,
+ * except through sink when there is a single thread.
+ */
+template<typename KeyT, typename ValueT, typename Sink>
+static void _probeAll(const HashMap<KeyT, ValueT> &source, const HashMap<KeyT, ValueT> &target, int threads,
+                      Sink sink)
+{
+    int capacity = source.capacity();
+    threads = std::max(1, std::min(threads, capacity / MIN_BUCKETS_PER_THREAD));
+    if (threads == 1)
+    {
+        _probeBuckets(source, target, 0, capacity, sink);
+        return;
+    }
+
+    typedef std::pair<const std::pair<KeyT, ValueT> *, const ValueT *> Match;
+    std::vector<std::vector<Match>> matches(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            auto collect = [&matches, t](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+            {
+                matches[t].emplace_back(&pair, value);
+            };
+            _probeBuckets(source, target, (int) ((long long) capacity * t / threads),
+                          (int) ((long long) capacity * (t + 1) / threads), collect);
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    for (auto &threadMatches : matches)
+    {
+        for (const Match &match : threadMatches)
+        {
+            sink(*match.first, match.second);
+        }
+    }
+}
+
+/**
+ * Returns the pairs of the first map whose keys are also in the second.
+ *
+ * @param first The first map.
+ * @param second The second map.
+ * @param threads How many threads may probe.
+ * @return A map of the keys in both maps, with their values in the first map.
+ */
+template<typename KeyT, typename ValueT>
+HashMap<KeyT, ValueT> intersect(const HashMap<KeyT, ValueT> &first, const HashMap<KeyT, ValueT> &second,
+                                int threads = 1)
+{
+    HashMap<KeyT, ValueT> result;
+    if (first.size() <= second.size())
+    {
+        _probeAll(first, second, threads, [&result](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+        {
+            if (value != nullptr)
+            {
+                result.insert(pair.first, pair.second);
+            }
+        });
+    }
+    else
+    {
+        _probeAll(second, first, threads, [&result](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+        {
+            if (value != nullptr)
+            {
+                result.insert(pair.first, *value);
+            }
+        });
+    }
+    return result;
+}
+
+/**
+ * Returns the pairs of both maps, with the values of the first map for keys in both.
+ *
+ * @param first The first map.
+ * @param second The second map.
+ * @param threads How many threads may probe.
+ * @return A map of the keys in either map.
+ */
+template<typename KeyT, typename ValueT>
+HashMap<KeyT, ValueT> unite(const HashMap<KeyT, ValueT> &first, const HashMap<KeyT, ValueT> &second,
+                            int threads = 1)
+{
+    if (first.size() >= second.size())
+    {
+        HashMap<KeyT, ValueT> result(first);
+        _probeAll(second, first, threads, [&result](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+        {
+            if (value == nullptr)
+            {
+                result.insert(pair.first, pair.second);
+            }
+        });
+        return result;
+    }
+
+    HashMap<KeyT, ValueT> result(second);
+    _probeAll(first, second, threads, [&result](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+    {
+        if (value == nullptr)
+        {
+            result.insert(pair.first, pair.second);
+        }
+        else
+        {
+            result.at(pair.first) = pair.second;
+        }
+    });
+    return result;
+}
+
+/**
+ * Returns the pairs of the first map whose keys aren't in the second.
+ *
+ * @param first The first map.
+ * @param second The second map.
+ * @param threads How many threads may probe.
+ * @return A map of the keys only in the first map.
+ */
+template<typename KeyT, typename ValueT>
+HashMap<KeyT, ValueT> difference(const HashMap<KeyT, ValueT> &first, const HashMap<KeyT, ValueT> &second,
+                                 int threads = 1)
+{
+    if (first.size() <= second.size())
+    {
+        HashMap<KeyT, ValueT> result;
+        _probeAll(first, second, threads, [&result](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+        {
+            if (value == nullptr)
+            {
+                result.insert(pair.first, pair.second);
+            }
+        });
+        return result;
+    }
+
+    HashMap<KeyT, ValueT> result(first);
+    _probeAll(second, first, threads, [&result](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+    {
+        if (value != nullptr)
+        {
+            result.erase(pair.first);
+        }
+    });
+    return result;
+}
+
+/**
+ * Returns the pairs of both maps whose keys are in only one of them.
+ *
+ * @param first The first map.
+ * @param second The second map.
+ * @param threads How many threads may probe.
+ * @return A map of the keys in exactly one of the maps.
+ */
+template<typename KeyT, typename ValueT>
+HashMap<KeyT, ValueT> symmetricDifference(const HashMap<KeyT, ValueT> &first, const HashMap<KeyT, ValueT> &second,
+                                          int threads = 1)
+{
+    const HashMap<KeyT, ValueT> &larger = (first.size() >= second.size()) ? first : second;
+    const HashMap<KeyT, ValueT> &smaller = (first.size() >= second.size()) ? second : first;
+    HashMap<KeyT, ValueT> result(larger);
+    _probeAll(smaller, larger, threads, [&result](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+    {
+        if (value != nullptr)
+        {
+            result.erase(pair.first);
+        }
+        else
+        {
+            result.insert(pair.first, pair.second);
+        }
+    });
+    return result;
+}
+
+/**
+ * Erases from the first map the keys that aren't in the second.
+ *
+ * @param first The map to change.
+ * @param second The other map.
+ * @param threads How many threads may probe.
+ */
+template<typename KeyT, typename ValueT>
+void intersectWith(HashMap<KeyT, ValueT> &first, const HashMap<KeyT, ValueT> &second, int threads = 1)
+{
+    if (second.size() < first.size()) // The result is no larger than the second map, so build it.
+    {
+        first = intersect(first, second, threads);
+        return;
+    }
+
+    std::vector<KeyT> missing;
+    _probeAll(first, second, threads, [&missing](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+    {
+        if (value == nullptr)
+        {
+            missing.push_back(pair.first);
+        }
+    });
+    for (const KeyT &key : missing)
+    {
+        first.erase(key);
+    }
+}
+
+/**
+ * Inserts into the first map the pairs of the second whose keys it doesn't have.
+ *
+ * @param first The map to change.
+ * @param second The other map.
+ * @param threads How many threads may probe.
+ */
+template<typename KeyT, typename ValueT>
+void uniteWith(HashMap<KeyT, ValueT> &first, const HashMap<KeyT, ValueT> &second, int threads = 1)
+{
+    std::vector<const std::pair<KeyT, ValueT> *> missing;
+    _probeAll(second, first, threads, [&missing](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+    {
+        if (value == nullptr)
+        {
+            missing.push_back(&pair);
+        }
+    });
+    for (auto *pair : missing)
+    {
+        first.insert(pair->first, pair->second);
+    }
+}
+
+/**
+ * Erases from the first map the keys that are in the second.
+ *
+ * @param first The map to change.
+ * @param second The other map.
+ * @param threads How many threads may probe.
+ */
+template<typename KeyT, typename ValueT>
+void subtract(HashMap<KeyT, ValueT> &first, const HashMap<KeyT, ValueT> &second, int threads = 1)
+{
+    std::vector<KeyT> present;
+    auto collect = [&present](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+    {
+        if (value != nullptr)
+        {
+            present.push_back(pair.first);
+        }
+    };
+    if (second.size() <= first.size())
+    {
+        _probeAll(second, first, threads, collect);
+    }
+    else
+    {
+        _probeAll(first, second, threads, collect);
+    }
+    for (const KeyT &key : present)
+    {
+        first.erase(key);
+    }
+}
+
+/**
+ * Erases from the first map the keys that are in the second, and inserts the pairs of the second
+ * whose keys it didn't have.
+ *
+ * @param first The map to change.
+ * @param second The other map.
+ * @param threads How many threads may probe.
+ */
+template<typename KeyT, typename ValueT>
+void symmetricDifferenceWith(HashMap<KeyT, ValueT> &first, const HashMap<KeyT, ValueT> &second, int threads = 1)
+{
+    std::vector<const std::pair<KeyT, ValueT> *> present, missing;
+    _probeAll(second, first, threads,
+              [&present, &missing](const std::pair<KeyT, ValueT> &pair, const ValueT *value)
+              {
+                  (value != nullptr ? present : missing).push_back(&pair);
+              });
+    for (auto *pair : present)
+    {
+        first.erase(pair->first);
+    }
+    for (auto *pair : missing)
+    {
+        first.insert(pair->first, pair->second);
+    }
+}
+
+#endif //SPAMDETECTOR_HASHMAPALGEBRA_HPP
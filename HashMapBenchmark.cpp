@@ -0,0 +1,618 @@
+/**
+ * @file HashMapBenchmark.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Micro-benchmark of the basic operations of every map layout.
+ *
+ * @section DESCRIPTION
+ * This file times inserts, successful and failed lookups, iteration and erases on every map
+ * layout for several key types, and reports for each the time and the hardware counters
+ * (instructions, cache misses, TLB misses and branch mispredictions) per operation.
+ * Every measurement is repeated; the median is printed and all samples go to the JSON report.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include "BenchUtils.hpp"
+#include "PerfCounters.hpp"
+#include "BenchReport.hpp"
+#include "HashMapAlgebra.hpp"
+#include "HashJoin.hpp"
+#include "GroupByAggregator.hpp"
+#include "PackedIntHashMap.hpp"
+#include "HashMultiMap.hpp"
+#include "FrontCodedHashMap.hpp"
+
+#define USAGE_MSG "Usage: HashMapBenchmark [entries] [repetitions] [--json <path>]"
+#define BENCHMARK_NAME "HashMapBenchmark"
+#define DEFAULT_ENTRIES 1000000
+#define DEFAULT_REPETITIONS 5
+#define ENTRIES_INDEX 1
+#define REPETITIONS_INDEX 2
+#define NS_PER_OP "ns/op"
+#define NAME_WIDTH 16
+#define TYPE_WIDTH 12
+#define NUMBER_WIDTH 11
+#define OVERLAP_DIVISOR 8
+#define ROWS_PER_GROUP 4
+#define GROUP_BY_THREADS 4
+#define HOT_KEYS 256
+#define HOT_PERCENT 90
+#define CHAINS 256
+#define CHAIN_LENGTH 32
+#define CHAIN_SHIFT 20
+#define PACKED_BITS 12
+
+/**
+ * Measurement context: the counters, the report, and which repetition is the last one (the one
+ * that prints).
+ */
+struct Measurement
+{
+    PerfCounters counters;
+    BenchReport &report;
+    bool print;
+};
+
+/*
+ * Runs an operation count times between the counters and records its time per operation.
+ * On the last repetition, prints a line with the median time and the counters per operation.
+ */
+template<typename Layout, typename KeyT, typename Operation>
+static void measureOperation(Measurement &measurement, const char *operation, int keyLength, int count,
+                             Operation run)
+{
+    auto start = std::chrono::steady_clock::now();
+    measurement.counters.start();
+    run();
+    PerfSample sample = measurement.counters.stop();
+    double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::string keyName = BenchData<KeyT>::name(keyLength);
+    std::vector<double> &samples = measurement.report.samples(
+            std::string(Layout::name()) + "/" + keyName + "/" + operation, NS_PER_OP, true);
+    samples.push_back(nanoseconds / count);
+    if (measurement.print)
+    {
+        std::vector<double> sorted(samples);
+        std::sort(sorted.begin(), sorted.end());
+        std::cout << std::left << std::setw(NAME_WIDTH) << Layout::name() << std::setw(TYPE_WIDTH) << keyName
+                  << std::setw(TYPE_WIDTH) << operation << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(NUMBER_WIDTH) << sorted[sorted.size() / 2]
+                  << sample.perOperation(count, NUMBER_WIDTH) << std::endl;
+    }
+}
+
+// Measures every operation on a layout with the given keys (present) and missing keys (absent).
+template<typename Layout, typename KeyT>
+static void measure(Measurement &measurement, const std::vector<KeyT> &keys, const std::vector<KeyT> &missing,
+                    int keyLength)
+{
+    typename Layout::template Map<KeyT, int> map;
+    int count = keys.size(), found = 0;
+    measureOperation<Layout, KeyT>(measurement, "insert", keyLength, count, [&]()
+    {
+        for (int i = 0; i < count; i++)
+        {
+            Layout::insert(map, keys[i], i);
+        }
+    });
+    measureOperation<Layout, KeyT>(measurement, "find-hit", keyLength, count, [&]()
+    {
+        for (const KeyT &key : keys)
+        {
+            found += Layout::contains(map, key);
+        }
+    });
+    measureOperation<Layout, KeyT>(measurement, "find-miss", keyLength, count, [&]()
+    {
+        for (const KeyT &key : missing)
+        {
+            found += Layout::contains(map, key);
+        }
+    });
+    measureOperation<Layout, KeyT>(measurement, "iterate", keyLength, count, [&]()
+    {
+        for (const auto &pair : map)
+        {
+            found += pair.second;
+        }
+    });
+    measureOperation<Layout, KeyT>(measurement, "erase", keyLength, count, [&]()
+    {
+        for (const KeyT &key : keys)
+        {
+            Layout::erase(map, key);
+        }
+    });
+    doNotOptimize(found);
+}
+
+/*
+ * Measures replacing every key with a new one, one call at a time (which shrinks and grows the
+ * map on the way) and as a single batch (which doesn't resize at all).
+ */
+template<typename KeyT>
+static void measureBatch(Measurement &measurement, const std::vector<KeyT> &keys, const std::vector<KeyT> &missing,
+                         int keyLength)
+{
+    typedef HashMap<KeyT, int> Map;
+    int count = keys.size();
+    std::vector<typename Map::BatchOp> ops;
+    for (int i = 0; i < count; i++)
+    {
+        ops.push_back(Map::BatchOp::remove(keys[i]));
+    }
+    for (int i = 0; i < count; i++)
+    {
+        ops.push_back(Map::BatchOp::insert(missing[i], i));
+    }
+
+    Map single(keys, std::vector<int>(count)), batched(single);
+    measureOperation<ChainedLayout, KeyT>(measurement, "replace", keyLength, 2 * count, [&]()
+    {
+        for (const auto &op : ops)
+        {
+            op.erase ? single.erase(op.key) : single.insert(op.key, op.value);
+        }
+    });
+    measureOperation<ChainedLayout, KeyT>(measurement, "batch-replace", keyLength, 2 * count, [&]()
+    {
+        batched.applyBatch(ops);
+    });
+}
+
+// Checks the size of a set operation's result against the expected size, reporting a mismatch.
+static void checkSize(const char *operation, int size, int expected)
+{
+    if (size != expected)
+    {
+        std::cerr << "The " << operation << " has " << size << " pairs instead of " << expected << "." << std::endl;
+    }
+}
+
+// Checks the results of the set operations on two maps (both ways) against counts by containsKey().
+template<typename KeyT>
+static void checkAlgebra(const HashMap<KeyT, int> &large, const HashMap<KeyT, int> &small)
+{
+    int both = 0;
+    for (const auto &pair : small)
+    {
+        both += large.containsKey(pair.first);
+    }
+    int sizes = large.size() + small.size();
+    checkSize("intersection", intersect(large, small).size(), both);
+    checkSize("intersection", intersect(small, large).size(), both);
+    checkSize("union", unite(large, small).size(), sizes - both);
+    checkSize("union", unite(small, large).size(), sizes - both);
+    checkSize("difference", difference(large, small).size(), large.size() - both);
+    checkSize("difference", difference(small, large).size(), small.size() - both);
+    checkSize("symmetric difference", symmetricDifference(large, small).size(), sizes - 2 * both);
+    checkSize("symmetric difference", symmetricDifference(small, large).size(), sizes - 2 * both);
+}
+
+// Times batched against single lookups and hashing, and set intersection against a loop over the larger map.
+template<typename KeyT>
+static void measureAlgebra(Measurement &measurement, const std::vector<KeyT> &keys,
+                           const std::vector<KeyT> &missing, int keyLength)
+{
+    typedef HashMap<KeyT, int> Map;
+    int count = keys.size(), part = count / OVERLAP_DIVISOR;
+    Map large(keys, std::vector<int>(count)), small;
+    for (int i = 0; i < part; i++) // Half of the small map's keys are in the large one.
+    {
+        small.insert(keys[i * OVERLAP_DIVISOR], i);
+        small.insert(missing[i], i);
+    }
+
+    std::vector<const KeyT *> pointers;
+    for (const KeyT &key : keys)
+    {
+        pointers.push_back(&key);
+    }
+    std::vector<const int *> values(count);
+    measureOperation<ChainedLayout, KeyT>(measurement, "find-batch", keyLength, count, [&]()
+    {
+        large.findBatch(pointers.data(), count, values.data());
+    });
+    std::vector<size_t> hashes(count);
+    measureOperation<ChainedLayout, KeyT>(measurement, "hash", keyLength, count, [&]()
+    {
+        for (int i = 0; i < count; i++)
+        {
+            hashes[i] = std::hash<KeyT>{}(keys[i]);
+        }
+    });
+    measureOperation<ChainedLayout, KeyT>(measurement, "hash-batch", keyLength, count, [&]()
+    {
+        BatchHash<KeyT>::hash(pointers.data(), count, hashes.data());
+    });
+
+    int loopSize = 0, intersectSize = 0;
+    measureOperation<ChainedLayout, KeyT>(measurement, "intersect-loop", keyLength, count, [&]()
+    {
+        Map result;
+        for (const auto &pair : large)
+        {
+            if (small.containsKey(pair.first))
+            {
+                result.insert(pair.first, pair.second);
+            }
+        }
+        loopSize = result.size();
+    });
+    measureOperation<ChainedLayout, KeyT>(measurement, "intersect", keyLength, count, [&]()
+    {
+        intersectSize = intersect(large, small).size();
+    });
+    checkSize("intersection", intersectSize, loopSize);
+    checkAlgebra(large, small);
+}
+
+// Times joining a stream of keys, half of them missing, with at() and catch against hashJoin().
+template<typename KeyT>
+static void measureJoin(Measurement &measurement, const std::vector<KeyT> &keys, const std::vector<KeyT> &missing,
+                        int keyLength)
+{
+    int count = keys.size();
+    HashMap<KeyT, int> build(keys, std::vector<int>(count, 1));
+    std::vector<KeyT> stream;
+    for (int i = 0; i < count; i++)
+    {
+        stream.push_back(keys[i]);
+        stream.push_back(missing[i]);
+    }
+
+    long long matched = 0;
+    measureOperation<ChainedLayout, KeyT>(measurement, "join-at", keyLength, 2 * count, [&]()
+    {
+        for (const KeyT &key : stream)
+        {
+            try
+            {
+                matched += build.at(key);
+            }
+            catch (KeyNotFoundException &)
+            {
+            }
+        }
+    });
+    measureOperation<ChainedLayout, KeyT>(measurement, "join", keyLength, 2 * count, [&]()
+    {
+        hashJoin(build, stream.begin(), stream.end(), INNER_JOIN, [&matched](const KeyT &, const int *value)
+        {
+            matched += *value;
+        });
+    });
+    if (matched != 2LL * count)
+    {
+        std::cerr << "The joins differ." << std::endl;
+    }
+}
+
+// Times summing and counting rows by key with operator[] against the GroupByAggregator.
+template<typename KeyT>
+static void measureGroupBy(Measurement &measurement, const std::vector<KeyT> &keys, int keyLength)
+{
+    int count = keys.size(), rows = ROWS_PER_GROUP * count;
+    std::vector<KeyT> column;
+    std::vector<long long> values;
+    for (int i = 0; i < rows; i++)
+    {
+        column.push_back(keys[benchMix(i) % count]);
+        values.push_back(i);
+    }
+
+    long long total = 0;
+    measureOperation<ChainedLayout, KeyT>(measurement, "groupby-loop", keyLength, rows, [&]()
+    {
+        HashMap<KeyT, std::pair<long long, long long>> groups;
+        for (int i = 0; i < rows; i++)
+        {
+            auto &group = groups[column[i]];
+            group.first += values[i];
+            group.second++;
+        }
+        for (const auto &group : groups)
+        {
+            total += group.second.second;
+        }
+    });
+    measureOperation<ChainedLayout, KeyT>(measurement, "groupby", keyLength, rows, [&]()
+    {
+        GroupByAggregator<KeyT, long long, Sum, Count> groups;
+        groups.addBatch(column.data(), values.data(), rows);
+        groups.forEachGroup([&total](const KeyT &, const std::tuple<Sum<long long>, Count<long long>> &state)
+        {
+            total += std::get<1>(state).result();
+        });
+    });
+    measureOperation<ChainedLayout, KeyT>(measurement, "groupby-par", keyLength, rows, [&]()
+    {
+        GroupByAggregator<KeyT, long long, Sum, Count> groups;
+        groups.addParallel(column.data(), values.data(), rows, GROUP_BY_THREADS);
+        groups.forEachGroup([&total](const KeyT &, const std::tuple<Sum<long long>, Count<long long>> &state)
+        {
+            total += std::get<1>(state).result();
+        });
+    });
+    if (total != 3LL * rows)
+    {
+        std::cerr << "The aggregations differ." << std::endl;
+    }
+}
+
+// Times adding and scanning several values per key in a HashMap of vectors and in a HashMultiMap.
+template<typename KeyT>
+static void measureMultiMap(Measurement &measurement, const std::vector<KeyT> &keys, int keyLength)
+{
+    int count = keys.size(), rows = ROWS_PER_GROUP * count;
+    HashMap<KeyT, std::vector<int>> vectors;
+    HashMultiMap<KeyT, int> runs;
+    measureOperation<ChainedLayout, KeyT>(measurement, "vector-add", keyLength, rows, [&]()
+    {
+        for (int i = 0; i < rows; i++)
+        {
+            vectors[keys[benchMix(i) % count]].push_back(i);
+        }
+    });
+    measureOperation<ChainedLayout, KeyT>(measurement, "multi-add", keyLength, rows, [&]()
+    {
+        for (int i = 0; i < rows; i++)
+        {
+            runs.insert(keys[benchMix(i) % count], i);
+        }
+    });
+
+    long long vectorTotal = 0, runTotal = 0;
+    measureOperation<ChainedLayout, KeyT>(measurement, "vector-scan", keyLength, rows, [&]()
+    {
+        for (const KeyT &key : keys)
+        {
+            for (int value : vectors[key])
+            {
+                vectorTotal += value;
+            }
+        }
+    });
+    measureOperation<ChainedLayout, KeyT>(measurement, "multi-scan", keyLength, rows, [&]()
+    {
+        for (const KeyT &key : keys)
+        {
+            auto range = runs.equal_range(key);
+            for (const int *value = range.first; value != range.second; value++)
+            {
+                runTotal += *value;
+            }
+        }
+    });
+    if (vectorTotal != runTotal)
+    {
+        std::cerr << "The multimaps differ." << std::endl;
+    }
+}
+
+// Times at() on a skewed stream (HOT_PERCENT of it on HOT_KEYS keys), without and with the front cache.
+template<typename KeyT>
+static void measureFrontCache(Measurement &measurement, const std::vector<KeyT> &keys, int keyLength)
+{
+    int count = keys.size(), hot = std::min(count, HOT_KEYS);
+    HashMap<KeyT, int> map(keys, std::vector<int>(count, 1));
+    std::vector<const KeyT *> stream(count);
+    for (int i = 0; i < count; i++)
+    {
+        size_t random = benchMix(i);
+        stream[i] = &keys[(random % 100 < HOT_PERCENT) ? (random / 100) % hot : (random / 100) % count];
+    }
+
+    long long plain = 0, cached = 0;
+    measureOperation<ChainedLayout, KeyT>(measurement, "skewed-at", keyLength, count, [&]()
+    {
+        for (const KeyT *key : stream)
+        {
+            plain += map.at(*key);
+        }
+    });
+    map.setFrontCache();
+    measureOperation<ChainedLayout, KeyT>(measurement, "skewed-cache", keyLength, count, [&]()
+    {
+        for (const KeyT *key : stream)
+        {
+            cached += map.at(*key);
+        }
+    });
+    if (plain != cached)
+    {
+        std::cerr << "The front cache changed a lookup." << std::endl;
+    }
+}
+
+// Front-coded keys are only strings.
+template<typename KeyT>
+static void measureFrontCoded(Measurement &, const std::vector<KeyT> &, const std::vector<KeyT> &, int)
+{}
+
+// Times successful and failed lookups in a FrontCodedHashMap.
+static void measureFrontCoded(Measurement &measurement, const std::vector<std::string> &keys,
+                              const std::vector<std::string> &missing, int keyLength)
+{
+    int count = keys.size();
+    FrontCodedHashMap<int> map(keys, std::vector<int>(count, 1));
+    long long found = 0;
+    measureOperation<ChainedLayout, std::string>(measurement, "coded-hit", keyLength, count, [&]()
+    {
+        for (const std::string &key : keys)
+        {
+            found += map.at(key);
+        }
+    });
+    measureOperation<ChainedLayout, std::string>(measurement, "coded-miss", keyLength, count, [&]()
+    {
+        for (const std::string &key : missing)
+        {
+            found += map.containsKey(key);
+        }
+    });
+    if (found != count)
+    {
+        std::cerr << "The front-coded map differs." << std::endl;
+    }
+}
+
+// Times skewed at() in buckets of CHAIN_LENGTH ints (which hash to themselves), with every bucket order.
+static void measureChains(Measurement &measurement, int count)
+{
+    std::vector<int> keys;
+    for (int j = 0; j < CHAIN_LENGTH; j++)
+    {
+        for (int i = 0; i < CHAINS; i++)
+        {
+            keys.push_back((j << CHAIN_SHIFT) | i);
+        }
+    }
+    std::vector<int> stream(count); // Mostly the last key of every bucket, which is scanned last.
+    for (int i = 0; i < count; i++)
+    {
+        size_t random = benchMix(i);
+        int j = (random % 100 < HOT_PERCENT) ? CHAIN_LENGTH - 1 : (random / 100) % CHAIN_LENGTH;
+        stream[i] = (j << CHAIN_SHIFT) | (int) ((random >> 32) % CHAINS);
+    }
+
+    const char *names[] = {"chain-at", "chain-count", "chain-swap", "chain-front"};
+    for (int order = UNORDERED_BUCKETS; order <= MOVE_TO_FRONT_ON_HIT; order++)
+    {
+        HashMap<int, int> map(keys, std::vector<int>(keys.size(), 1));
+        map.setBucketOrder((BucketOrder) order);
+        long long total = 0;
+        for (int key : stream) // Warms up the order, and for COUNT_HITS, the counts to reorganize by.
+        {
+            total += map.at(key);
+        }
+        map.reorganize();
+        measureOperation<ChainedLayout, int>(measurement, names[order], 0, count, [&]()
+        {
+            for (int key : stream)
+            {
+                total += map.at(key);
+            }
+        });
+        if (total != 2LL * count)
+        {
+            std::cerr << "A bucket order changed a lookup." << std::endl;
+        }
+    }
+}
+
+// Measures nothing: the flat layout only takes integer keys.
+template<typename KeyT>
+static void measureFlat(Measurement &, const std::vector<KeyT> &, const std::vector<KeyT> &, int, std::false_type)
+{}
+
+// Measures the flat layout of integer keys, and the same table with bit-packed values.
+template<typename KeyT>
+static void measureFlat(Measurement &measurement, const std::vector<KeyT> &keys, const std::vector<KeyT> &missing,
+                        int keyLength, std::true_type)
+{
+    measure<IntLayout>(measurement, keys, missing, keyLength);
+
+    int count = keys.size();
+    PackedIntHashMap<KeyT, PACKED_BITS> packed;
+    long long found = 0;
+    measureOperation<IntLayout, KeyT>(measurement, "packed-insert", keyLength, count, [&]()
+    {
+        for (int i = 0; i < count; i++)
+        {
+            packed.insert(keys[i], i % (1 << PACKED_BITS));
+        }
+    });
+    measureOperation<IntLayout, KeyT>(measurement, "packed-hit", keyLength, count, [&]()
+    {
+        for (const KeyT &key : keys)
+        {
+            found += packed.at(key);
+        }
+    });
+    measureOperation<IntLayout, KeyT>(measurement, "packed-add", keyLength, count, [&]()
+    {
+        for (const KeyT &key : keys)
+        {
+            packed[key] = packed.at(key) / 2 + 1;
+        }
+    });
+    doNotOptimize(found);
+}
+
+// Measures every layout with the given key type, repeatedly.
+template<typename KeyT>
+static void measureAll(Measurement &measurement, int count, int repetitions, int keyLength)
+{
+    std::vector<KeyT> all = benchItems<KeyT>(2 * count, keyLength);
+    std::vector<KeyT> keys(all.begin(), all.begin() + count), missing(all.begin() + count, all.end());
+    for (int i = 0; i < repetitions; i++)
+    {
+        measurement.print = (i == repetitions - 1);
+        measure<ChainedLayout>(measurement, keys, missing, keyLength);
+        measureBatch(measurement, keys, missing, keyLength);
+        measureAlgebra(measurement, keys, missing, keyLength);
+        measureJoin(measurement, keys, missing, keyLength);
+        measureGroupBy(measurement, keys, keyLength);
+        measureMultiMap(measurement, keys, keyLength);
+        measureFrontCache(measurement, keys, keyLength);
+        measureFrontCoded(measurement, keys, missing, keyLength);
+    }
+    for (int i = 0; i < repetitions; i++)
+    {
+        measurement.print = (i == repetitions - 1);
+        measure<StdLayout>(measurement, keys, missing, keyLength);
+    }
+    for (int i = 0; i < repetitions; i++)
+    {
+        measurement.print = (i == repetitions - 1);
+        measureFlat(measurement, keys, missing, keyLength, std::is_integral<KeyT>());
+    }
+}
+
+/**
+ * Program's main that receives an optional entry count and repetition count, and prints the
+ * median time and the hardware counters per operation of every layout ("-" marks counters that
+ * aren't available).
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    BenchReport report(BENCHMARK_NAME, argc, argv);
+    int count = (argc > ENTRIES_INDEX) ? std::atoi(argv[ENTRIES_INDEX]) : DEFAULT_ENTRIES;
+    int repetitions = (argc > REPETITIONS_INDEX) ? std::atoi(argv[REPETITIONS_INDEX]) : DEFAULT_REPETITIONS;
+    if (argc > REPETITIONS_INDEX + 1 || count <= 0 || repetitions <= 0)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Measurement measurement{{}, report, false};
+    if (!measurement.counters.available())
+    {
+        std::cerr << "Hardware counters are not available; reporting times only." << std::endl;
+    }
+    std::cout << std::left << std::setw(NAME_WIDTH) << "layout" << std::setw(TYPE_WIDTH) << "key"
+              << std::setw(TYPE_WIDTH) << "operation" << std::right << std::setw(NUMBER_WIDTH) << "ns/op"
+              << PerfCounters::names(NUMBER_WIDTH) << std::endl;
+
+    measureAll<int>(measurement, count, repetitions, 0);
+    for (int i = 0; i < repetitions; i++)
+    {
+        measurement.print = (i == repetitions - 1);
+        measureChains(measurement, count);
+    }
+    measureAll<long long>(measurement, count, repetitions, 0);
+    measureAll<std::string>(measurement, count, repetitions, 8);
+    measureAll<std::string>(measurement, count, repetitions, 32);
+    return report.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file HashMapTrace.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Tracing hooks of the HashMap: static probes and an observer interface.
+ *
+ * @section DESCRIPTION
+ * This file defines the USDT (SystemTap SDT) probes that HashMap fires, which cost a single nop
+ * until a tracer such as bpftrace attaches to them, and the observer interface for reacting to
+ * the same events in process. Without <sys/sdt.h>, or with HASHMAP_NO_PROBES defined, the probes
+ * compile to nothing.
+ *
+ * Probes (provider "hashmap"):
+ * rehash_start(map, old capacity, new capacity)
+ * rehash_end(map, old capacity, new capacity, nanoseconds)
+ * long_probe(map, bucket, bucket length)
+ * allocation_failure(map, bytes)
+ *
+ * For example: bpftrace -e 'usdt:./SpamDetector:hashmap:rehash_end { @ns = hist(arg3); }'
+ */
+
+#ifndef SPAMDETECTOR_HASHMAPTRACE_HPP
+#define SPAMDETECTOR_HASHMAPTRACE_HPP
+
+#include <cstddef>
+
+#if defined(__has_include) && !defined(HASHMAP_NO_PROBES)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define HASHMAP_PROBE2(name, a, b) DTRACE_PROBE2(hashmap, name, a, b)
+#define HASHMAP_PROBE3(name, a, b, c) DTRACE_PROBE3(hashmap, name, a, b, c)
+#define HASHMAP_PROBE4(name, a, b, c, d) DTRACE_PROBE4(hashmap, name, a, b, c, d)
+#endif
+#endif
+
+#ifndef HASHMAP_PROBE2
+#define HASHMAP_PROBE2(name, a, b) do {} while (0)
+#define HASHMAP_PROBE3(name, a, b, c) do {} while (0)
+#define HASHMAP_PROBE4(name, a, b, c, d) do {} while (0)
+#endif
+
+#define DEFAULT_PROBE_LIMIT 8
+
+/**
+ * Observer of the internal events of a HashMap. Every callback is called on the thread that
+ * caused the event, inside the map's operation, so it must be quick and must not use the map.
+ * The map is passed as an opaque pointer, to tell maps apart.
+ */
+class HashMapObserver
+{
+public:
+    virtual ~HashMapObserver() = default;
+
+    /**
+     * Called before a map changes its capacity, once it has the new table, so that every call is
+     * followed by rehashFinished().
+     *
+     * @param map The map.
+     * @param oldCapacity The capacity before the rehash.
+     * @param newCapacity The capacity after the rehash.
+     */
+    virtual void rehashStarted(const void * /*map*/, int /*oldCapacity*/, int /*newCapacity*/) noexcept
+    {}
+
+    /**
+     * Called after a map changed its capacity.
+     *
+     * @param map The map.
+     * @param oldCapacity The capacity before the rehash.
+     * @param newCapacity The capacity after the rehash.
+     * @param nanoseconds How long the rehash took.
+     */
+    virtual void rehashFinished(const void * /*map*/, int /*oldCapacity*/, int /*newCapacity*/,
+                                long long /*nanoseconds*/) noexcept
+    {}
+
+    /**
+     * Called when a lookup goes to a bucket longer than the map's probe limit.
+     *
+     * @param map The map.
+     * @param bucket The index of the bucket.
+     * @param length The length of the bucket.
+     */
+    virtual void longProbe(const void * /*map*/, int /*bucket*/, int /*length*/) noexcept
+    {}
+
+    /**
+     * Called when a map fails to allocate. A failed rehash leaves the map at its old capacity;
+     * other failures are thrown after the call.
+     *
+     * @param map The map.
+     * @param bytes How many bytes were requested (0 if unknown).
+     */
+    virtual void allocationFailed(const void * /*map*/, size_t /*bytes*/) noexcept
+    {}
+};
+
+#endif //SPAMDETECTOR_HASHMAPTRACE_HPP
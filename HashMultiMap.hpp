@@ -0,0 +1,306 @@
+/**
+ * @file HashMultiMap.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Map from keys to many values, with the values of every key stored contiguously.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for a multimap. The values of all keys live in one
+ * shared arena, and every key's entry in a HashMap holds the offset, length and capacity of its
+ * run of values there. Scanning the values of a key is a single sequential read, with no
+ * allocation or pointer chase per key besides the entry itself. A run that outgrows its capacity
+ * moves to the end of the arena with twice the room (or grows in place if it is already there),
+ * and the arena is compacted once more than half of it is abandoned runs.
+ */
+
+#ifndef SPAMDETECTOR_HASHMULTIMAP_HPP
+#define SPAMDETECTOR_HASHMULTIMAP_HPP
+
+#include "HashMap.hpp"
+
+#define MIN_RUN_CAPACITY 2
+#define MIN_COMPACT_SIZE 1024
+
+/**
+ * Map from keys to any number of values, kept in the order they were added.
+ *
+ * @tparam KeyT The key type.
+ * @tparam ValueT The value type.
+ */
+template<typename KeyT, typename ValueT>
+class HashMultiMap
+{
+    // Where the values of a key are in the arena.
+    struct _Run
+    {
+        int offset = 0, length = 0, capacity = 0;
+    };
+
+    HashMap<KeyT, _Run> _index;
+    std::vector<ValueT> _arena;
+    int _size, _abandoned;
+
+    // Returns the run of a key, or nullptr if it has no values.
+    const _Run *_find(const KeyT &key) const noexcept
+    {
+        const KeyT *keys[] = {&key};
+        const _Run *run = nullptr;
+        _index.findBatch(keys, 1, &run);
+        return run;
+    }
+
+    // Makes room for more values in a run, moving it to the end of the arena if it's too small.
+    void _reserve(_Run &run, int added)
+    {
+        if (run.length + added <= run.capacity)
+        {
+            return;
+        }
+        int capacity = std::max(MIN_RUN_CAPACITY, run.capacity);
+        while (capacity < run.length + added)
+        {
+            capacity *= CHANGE_FACTOR;
+        }
+        if (run.offset + run.capacity == (int) _arena.size()) // The last run grows in place.
+        {
+            _arena.resize(run.offset + capacity);
+            run.capacity = capacity;
+            return;
+        }
+
+        int offset = _arena.size();
+        _arena.resize(offset + capacity);
+        std::copy(_arena.begin() + run.offset, _arena.begin() + run.offset + run.length, _arena.begin() + offset);
+        _abandoned += run.capacity;
+        run.offset = offset;
+        run.capacity = capacity;
+    }
+
+    // Erases a key that was added to the index for values it couldn't get, so no key has an empty run.
+    void _eraseIfEmpty(const KeyT &key, const _Run &run) noexcept
+    {
+        if (run.length == 0)
+        {
+            _abandoned += run.capacity;
+            _index.erase(key);
+        }
+    }
+
+    // Rewrites the arena without the abandoned runs, if they are most of it.
+    void _compactIfSparse()
+    {
+        if (_abandoned * 2 > (int) _arena.size() && (int) _arena.size() >= MIN_COMPACT_SIZE)
+        {
+            compact();
+        }
+    }
+
+public:
+    /**
+     * Creates an empty multimap.
+     */
+    HashMultiMap() noexcept : _size(0), _abandoned(0)
+    {}
+
+    /**
+     * Returns how many values there are, of all keys.
+     *
+     * @return How many values there are.
+     */
+    int size() const noexcept
+    {
+        return _size;
+    }
+
+    /**
+     * Returns how many keys have values.
+     *
+     * @return How many keys have values.
+     */
+    int keyCount() const noexcept
+    {
+        return _index.size();
+    }
+
+    /**
+     * Returns true if there are no values.
+     *
+     * @return True if there are no values.
+     */
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    /**
+     * Adds a value after the other values of a key.
+     *
+     * @param key The key.
+     * @param value The value.
+     * @throws std::bad_alloc (or what copying the value throws), leaving the key's values unchanged.
+     */
+    void insert(const KeyT &key, const ValueT &value)
+    {
+        _compactIfSparse();
+        _Run &run = _index[key];
+        try
+        {
+            _reserve(run, 1);
+            _arena[run.offset + run.length] = value;
+        }
+        catch (...)
+        {
+            _eraseIfEmpty(key, run);
+            throw;
+        }
+        run.length++;
+        _size++;
+    }
+
+    /**
+     * Adds a range of values after the other values of a key, moving the key's run at most once.
+     *
+     * @param key The key.
+     * @param first The first value.
+     * @param last The end of the values (a forward iterator).
+     * @throws std::bad_alloc (or what copying the values throws), leaving the key's values unchanged.
+     */
+    template<typename Iterator>
+    void append(const KeyT &key, Iterator first, Iterator last)
+    {
+        int added = std::distance(first, last);
+        if (added == 0)
+        {
+            return;
+        }
+        _compactIfSparse();
+        _Run &run = _index[key];
+        try
+        {
+            _reserve(run, added);
+            std::copy(first, last, _arena.begin() + run.offset + run.length);
+        }
+        catch (...)
+        {
+            _eraseIfEmpty(key, run);
+            throw;
+        }
+        run.length += added;
+        _size += added;
+    }
+
+    /**
+     * Returns the values of a key, as a range of pointers that stays valid until the next change.
+     *
+     * @param key The key.
+     * @return The first value and the end of the values (equal if the key has none).
+     */
+    std::pair<const ValueT *, const ValueT *> equal_range(const KeyT &key) const noexcept
+    {
+        const _Run *run = _find(key);
+        if (run == nullptr)
+        {
+            return {nullptr, nullptr};
+        }
+        const ValueT *first = _arena.data() + run->offset;
+        return {first, first + run->length};
+    }
+
+    /**
+     * Returns how many values a key has.
+     *
+     * @param key The key.
+     * @return How many values the key has.
+     */
+    int count(const KeyT &key) const noexcept
+    {
+        const _Run *run = _find(key);
+        return (run == nullptr) ? 0 : run->length;
+    }
+
+    /**
+     * Returns true if a key has values.
+     *
+     * @param key The key.
+     * @return True if the key has values.
+     */
+    bool containsKey(const KeyT &key) const noexcept
+    {
+        return _find(key) != nullptr;
+    }
+
+    /**
+     * Erases all values of a key.
+     *
+     * @param key The key.
+     * @return How many values were erased.
+     */
+    int erase(const KeyT &key)
+    {
+        const _Run *run = _find(key);
+        if (run == nullptr)
+        {
+            return 0;
+        }
+        int length = run->length;
+        _abandoned += run->capacity;
+        _size -= length;
+        _index.erase(key);
+        _compactIfSparse();
+        return length;
+    }
+
+    /**
+     * Erases all keys and values.
+     */
+    void clear() noexcept
+    {
+        _index.clear();
+        _arena.clear();
+        _size = _abandoned = 0;
+    }
+
+    /**
+     * Rewrites the arena with the runs next to each other and no spare capacity, in the order of
+     * their keys in the index.
+     */
+    void compact()
+    {
+        std::vector<ValueT> arena;
+        arena.reserve(_size);
+        std::vector<const KeyT *> keys;
+        for (const auto &entry : _index)
+        {
+            keys.push_back(&entry.first);
+        }
+        for (const KeyT *key : keys)
+        {
+            _Run &run = _index.at(*key);
+            arena.insert(arena.end(), _arena.begin() + run.offset, _arena.begin() + run.offset + run.length);
+            run.offset = arena.size() - run.length;
+            run.capacity = run.length;
+        }
+        _arena.swap(arena);
+        _abandoned = 0;
+    }
+
+    /**
+     * Calls a function with every key and its values.
+     *
+     * @param function Called with the key (const KeyT &), the first value and the end of the
+     * values (const ValueT *).
+     */
+    template<typename Function>
+    void forEach(Function function) const
+    {
+        for (const auto &entry : _index)
+        {
+            const ValueT *first = _arena.data() + entry.second.offset;
+            function(entry.first, first, first + entry.second.length);
+        }
+    }
+};
+
+#endif //SPAMDETECTOR_HASHMULTIMAP_HPP
@@ -0,0 +1,568 @@
+/**
+ * @file IntHashMap.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Flat open-addressing map for integer keys.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for a map from integers that keeps its pairs in one
+ * flat array of slots, with no allocation per pair and no metadata bytes. An empty slot holds a
+ * reserved sentinel key (the largest key of the type); the sentinel key itself, if it is ever
+ * inserted, lives in one extra slot after the table. Keys are scattered by a strong integer mixer
+ * (the MurmurHash3 finalizer), so sequential and strided keys don't form clusters, and collisions
+ * probe linearly. Erasing shifts the following pairs of the cluster back instead of leaving
+ * tombstones, so lookups never scan dead slots. A table of 32-bit keys and values costs 8 bytes
+ * per slot, and one of 64-bit keys and values 16, at loads between INT_MAP_MAX_LOAD and half of it.
+ * The table logic lives in IntSlotTable, which PackedIntHashMap shares with other storage.
+ */
+
+#ifndef SPAMDETECTOR_INTHASHMAP_HPP
+#define SPAMDETECTOR_INTHASHMAP_HPP
+
+#include <vector>
+#include <limits>
+#include <type_traits>
+#include "HashMap.hpp"
+
+#define INT_MAP_MIN_CAPACITY 16
+#define INT_MAP_MAX_LOAD 0.8
+#define INT_MAP_MIN_LOAD 0.2
+#define INT_MIX_SHIFT 33
+#define INT_MIX_MULTIPLIER_1 0xff51afd7ed558ccdULL
+#define INT_MIX_MULTIPLIER_2 0xc4ceb9fe1a85ec53ULL
+
+/**
+ * Scatters the bits of an integer key over all bits of the result (the MurmurHash3 finalizer, a
+ * bijection), so that the low bits of the result can index a table.
+ *
+ * @param key The key.
+ * @return The scattered key.
+ */
+inline unsigned long long mixInt(unsigned long long key) noexcept
+{
+    key = (key ^ (key >> INT_MIX_SHIFT)) * INT_MIX_MULTIPLIER_1;
+    key = (key ^ (key >> INT_MIX_SHIFT)) * INT_MIX_MULTIPLIER_2;
+    return key ^ (key >> INT_MIX_SHIFT);
+}
+
+/**
+ * The probing, growing and erasing of a flat table of integer keys, shared by IntHashMap and
+ * PackedIntHashMap. Where the values are kept is up to SlotsT, which holds the key and value of
+ * every slot and provides:
+ * - SlotsT(size_t count, KeyT empty): count slots with the given key and a default value.
+ * - KeyT key(size_t i) const and void setKey(size_t i, KeyT key).
+ * - void move(size_t from, size_t to), and moveFrom(SlotsT &other, size_t from, size_t to) from
+ *   another table, which move a key and its value.
+ * - void clearValue(size_t i), and void clear(KeyT empty) that empties every slot.
+ * - value(size_t i), the value of a slot, and pair(size_t i) and pointer(size_t i), the pair of a
+ *   slot as the Reference and Pointer types of its iterators.
+ * - void swap(SlotsT &other) and size_t heapBytes() const.
+ *
+ * @tparam KeyT The key type (an integral type).
+ * @tparam SlotsT The storage of the slots.
+ */
+template<typename KeyT, typename SlotsT>
+class IntSlotTable
+{
+    static_assert(std::is_integral<KeyT>::value, "Integer maps' keys must be integers.");
+
+protected:
+    // The table, followed by the slot of the sentinel key.
+    SlotsT _slots;
+    size_t _mask;
+    int _used;
+    bool _hasSentinel;
+
+    // The key that marks empty slots.
+    static constexpr KeyT _sentinel() noexcept
+    {
+        return std::numeric_limits<KeyT>::max();
+    }
+
+    // Returns the slot a key would be in if there were no collisions.
+    size_t _home(KeyT key) const noexcept
+    {
+        return mixInt((unsigned long long) key) & _mask;
+    }
+
+    // Returns the slot of a key, or the empty slot that ends its cluster if it isn't in the table.
+    size_t _probe(KeyT key) const noexcept
+    {
+        size_t i = _home(key);
+        while (_slots.key(i) != key && _slots.key(i) != _sentinel())
+        {
+            i = (i + 1) & _mask;
+        }
+        return i;
+    }
+
+    // Returns the slot of a key, or -1 if it isn't in this map.
+    long long _find(KeyT key) const noexcept
+    {
+        if (key == _sentinel())
+        {
+            return _hasSentinel ? (long long) _mask + 1 : -1;
+        }
+        size_t i = _probe(key);
+        return (_slots.key(i) == key) ? (long long) i : -1;
+    }
+
+    // Moves every pair to a new table of the given capacity (a power of two).
+    void _rehash(size_t capacity)
+    {
+        SlotsT slots(capacity + 1, _sentinel());
+        slots.moveFrom(_slots, _mask + 1, capacity);
+        _slots.swap(slots);
+        size_t oldCapacity = _mask + 1;
+        _mask = capacity - 1;
+        for (size_t i = 0; i < oldCapacity; i++)
+        {
+            if (slots.key(i) != _sentinel())
+            {
+                _slots.moveFrom(slots, i, _probe(slots.key(i)));
+            }
+        }
+    }
+
+    // Returns the slot of a key, adding it with a default value (and growing) if it's new.
+    size_t _findOrAdd(KeyT key, bool &added)
+    {
+        if (key == _sentinel())
+        {
+            added = !_hasSentinel;
+            _hasSentinel = true;
+            return _mask + 1;
+        }
+        size_t i = _probe(key);
+        added = _slots.key(i) != key;
+        if (added)
+        {
+            if (_used + 1 > INT_MAP_MAX_LOAD * (_mask + 1))
+            {
+                _rehash((_mask + 1) * CHANGE_FACTOR);
+                i = _probe(key);
+            }
+            _slots.setKey(i, key);
+            _used++;
+        }
+        return i;
+    }
+
+    /**
+     * Creates an empty table.
+     */
+    IntSlotTable() : _slots(INT_MAP_MIN_CAPACITY + 1, _sentinel()), _mask(INT_MAP_MIN_CAPACITY - 1), _used(0),
+                     _hasSentinel(false)
+    {}
+
+public:
+    /**
+     * const forward iterator class for the integer maps. The pair of the sentinel key comes last.
+     */
+    class const_iterator
+    {
+        const SlotsT *_slots;
+        size_t _i, _table;
+
+        // Skips empty slots of the table.
+        void _skip() noexcept
+        {
+            while (_i < _table && _slots->key(_i) == _sentinel())
+            {
+                ++_i;
+            }
+        }
+
+    public:
+        // iterator traits.
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename std::decay<typename SlotsT::Reference>::type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename SlotsT::Pointer pointer;
+        typedef typename SlotsT::Reference reference;
+
+        /**
+         * Creates new iterator at a slot of a table.
+         *
+         * @param slots The slots of the table.
+         * @param i The slot to start at (skipping it if it is empty).
+         * @param table The end of the table, where the slot of the sentinel key is.
+         */
+        const_iterator(const SlotsT *slots, size_t i, size_t table) noexcept : _slots(slots), _i(i), _table(table)
+        {
+            _skip();
+        }
+
+        /**
+         * -> operator for iterator.
+         *
+         * @return Address of the current pair.
+         */
+        pointer operator->() const noexcept
+        {
+            return _slots->pointer(_i);
+        }
+
+        /**
+         * Dereference operator for iterator.
+         *
+         * @return The current pair.
+         */
+        reference operator*() const noexcept
+        {
+            return _slots->pair(_i);
+        }
+
+        /**
+         * Advances to operator by 1 and returns instance of this iterator after advancement.
+         *
+         * @return Instance of this iterator after advancement.
+         */
+        const_iterator &operator++() noexcept
+        {
+            ++_i;
+            _skip();
+            return *this;
+        }
+
+        /**
+         * Advances to operator by 1 and returns copy of this iterator before advancement.
+         *
+         * @return Copy of this iterator before advancement.
+         */
+        const const_iterator operator++(int) noexcept
+        {
+            const_iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        /**
+         * Returns true if both iterators point at the same slot. Otherwise, returns false.
+         *
+         * @param other The other iterator.
+         * @return True if both iterators point at the same slot. Otherwise, false.
+         */
+        bool operator==(const const_iterator &other) const noexcept
+        {
+            return _slots == other._slots && _i == other._i;
+        }
+
+        /**
+         * Returns true if both iterators don't point at the same slot. Otherwise, returns false.
+         *
+         * @param other The other iterator.
+         * @return True if both iterators don't point at the same slot. Otherwise, false.
+         */
+        bool operator!=(const const_iterator &other) const noexcept
+        {
+            return !(*this == other);
+        }
+    };
+
+    /**
+     * Returns how many pairs there are.
+     *
+     * @return How many pairs there are.
+     */
+    int size() const noexcept
+    {
+        return _used + _hasSentinel;
+    }
+
+    /**
+     * Returns how many slots the table has (besides the slot of the sentinel key).
+     *
+     * @return How many slots the table has.
+     */
+    int capacity() const noexcept
+    {
+        return _mask + 1;
+    }
+
+    /**
+     * Returns true if there are no pairs.
+     *
+     * @return True if there are no pairs.
+     */
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /**
+     * Returns the current load factor of the table.
+     *
+     * @return The current load factor of the table.
+     */
+    double getLoadFactor() const noexcept
+    {
+        return (double) _used / capacity();
+    }
+
+    /**
+     * Returns true if this map contains the given key. Otherwise, returns false.
+     *
+     * @param key The key to find.
+     * @return True if this map contains the given key. Otherwise, returns false.
+     */
+    bool containsKey(KeyT key) const noexcept
+    {
+        return _find(key) >= 0;
+    }
+
+    /**
+     * Returns true if the removal of the given key from this map is successful.
+     * Otherwise returns false. The pairs after it in its cluster move back to fill its slot.
+     *
+     * @param key The key to remove.
+     * @return True if the removal of the given key from this map is successful. Otherwise false.
+     */
+    bool erase(KeyT key)
+    {
+        if (key == _sentinel())
+        {
+            bool erased = _hasSentinel;
+            _hasSentinel = false;
+            _slots.clearValue(_mask + 1);
+            return erased;
+        }
+        size_t hole = _probe(key);
+        if (_slots.key(hole) != key)
+        {
+            return false;
+        }
+        for (size_t i = (hole + 1) & _mask; _slots.key(i) != _sentinel(); i = (i + 1) & _mask)
+        {
+            // A pair can fill the hole if its home isn't cyclically in (hole, i].
+            if (((i - _home(_slots.key(i))) & _mask) >= ((i - hole) & _mask))
+            {
+                _slots.move(i, hole);
+                hole = i;
+            }
+        }
+        _slots.setKey(hole, _sentinel());
+        _slots.clearValue(hole);
+        _used--;
+        if (_used < INT_MAP_MIN_LOAD * capacity() && capacity() > INT_MAP_MIN_CAPACITY)
+        {
+            _rehash(capacity() / CHANGE_FACTOR);
+        }
+        return true;
+    }
+
+    /**
+     * Erases all pairs, keeping the capacity.
+     */
+    void clear()
+    {
+        _slots.clear(_sentinel());
+        _used = 0;
+        _hasSentinel = false;
+    }
+
+    /**
+     * Returns an iterator at the first pair.
+     *
+     * @return An iterator at the first pair.
+     */
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(&_slots, 0, _mask + 1);
+    }
+
+    /**
+     * Returns an iterator past the last pair.
+     *
+     * @return An iterator past the last pair.
+     */
+    const_iterator end() const noexcept
+    {
+        return const_iterator(&_slots, _mask + 1 + _hasSentinel, _mask + 1);
+    }
+
+    /**
+     * Returns how many bytes this map holds on the heap.
+     *
+     * @return How many bytes this map holds on the heap.
+     */
+    size_t heapBytes() const noexcept
+    {
+        return _slots.heapBytes();
+    }
+};
+
+/**
+ * Slots of an IntHashMap: every key with its value beside it (see IntSlotTable).
+ *
+ * @tparam KeyT The key type.
+ * @tparam ValueT The value type (default constructible).
+ */
+template<typename KeyT, typename ValueT>
+class PairSlots
+{
+    std::vector<std::pair<KeyT, ValueT>> _pairs;
+
+public:
+    typedef const std::pair<KeyT, ValueT> &Reference;
+    typedef const std::pair<KeyT, ValueT> *Pointer;
+
+    // Creates count slots holding the given key and a default value.
+    PairSlots(size_t count, KeyT empty) : _pairs(count, std::pair<KeyT, ValueT>(empty, ValueT()))
+    {}
+
+    // Returns the key of a slot.
+    KeyT key(size_t i) const noexcept
+    {
+        return _pairs[i].first;
+    }
+
+    // Sets the key of a slot.
+    void setKey(size_t i, KeyT key) noexcept
+    {
+        _pairs[i].first = key;
+    }
+
+    // Moves the key and value of a slot to another.
+    void move(size_t from, size_t to)
+    {
+        _pairs[to] = std::move(_pairs[from]);
+    }
+
+    // Moves the key and value of a slot of another table to a slot of this one.
+    void moveFrom(PairSlots &other, size_t from, size_t to)
+    {
+        _pairs[to] = std::move(other._pairs[from]);
+    }
+
+    // Resets the value of a slot.
+    void clearValue(size_t i)
+    {
+        _pairs[i].second = ValueT();
+    }
+
+    // Sets every slot to the given key and a default value.
+    void clear(KeyT empty)
+    {
+        std::fill(_pairs.begin(), _pairs.end(), std::pair<KeyT, ValueT>(empty, ValueT()));
+    }
+
+    // Returns the value of a slot.
+    ValueT &value(size_t i) noexcept
+    {
+        return _pairs[i].second;
+    }
+
+    // Returns the value of a slot. (Const version)
+    const ValueT &value(size_t i) const noexcept
+    {
+        return _pairs[i].second;
+    }
+
+    // Returns the pair of a slot.
+    Reference pair(size_t i) const noexcept
+    {
+        return _pairs[i];
+    }
+
+    // Returns a pointer to the pair of a slot.
+    Pointer pointer(size_t i) const noexcept
+    {
+        return &_pairs[i];
+    }
+
+    // Swaps the slots with those of another table.
+    void swap(PairSlots &other) noexcept
+    {
+        _pairs.swap(other._pairs);
+    }
+
+    // Returns how many bytes the slots hold on the heap.
+    size_t heapBytes() const noexcept
+    {
+        return _pairs.capacity() * sizeof(std::pair<KeyT, ValueT>);
+    }
+};
+
+/**
+ * Map from integer keys to values, stored in a flat array of slots.
+ *
+ * @tparam KeyT The key type (an integral type).
+ * @tparam ValueT The value type (default constructible).
+ */
+template<typename KeyT, typename ValueT>
+class IntHashMap : public IntSlotTable<KeyT, PairSlots<KeyT, ValueT>>
+{
+public:
+    /**
+     * Creates an empty map.
+     */
+    IntHashMap() = default;
+
+    /**
+     * Returns true if insertion to this map is successful. Otherwise returns false.
+     * Failure to insert happens when key already exists in this map.
+     *
+     * @param key The key to insert.
+     * @param value The value to insert.
+     * @return True if insertion to this map is successful. Otherwise returns false.
+     */
+    bool insert(KeyT key, const ValueT &value)
+    {
+        bool added;
+        size_t i = this->_findOrAdd(key, added);
+        if (added)
+        {
+            this->_slots.value(i) = value;
+        }
+        return added;
+    }
+
+    /**
+     * Returns the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception. (Const version)
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return The value paired with the given key.
+     */
+    const ValueT &at(KeyT key) const
+    {
+        long long i = this->_find(key);
+        if (i < 0)
+        {
+            throw KeyNotFoundException();
+        }
+        return this->_slots.value(i);
+    }
+
+    /**
+     * Returns the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception.
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return The value paired with the given key.
+     */
+    ValueT &at(KeyT key)
+    {
+        return const_cast<ValueT &>(static_cast<const IntHashMap &>(*this).at(key));
+    }
+
+    /**
+     * Returns the value paired with the given key, pairing it with a default value first if it
+     * isn't in this map.
+     *
+     * @param key The key to find.
+     * @return The value paired with the given key.
+     */
+    ValueT &operator[](KeyT key)
+    {
+        bool added;
+        return this->_slots.value(this->_findOrAdd(key, added));
+    }
+};
+
+#endif //SPAMDETECTOR_INTHASHMAP_HPP
@@ -0,0 +1,234 @@
+/**
+ * @file LatencyBenchmark.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Tail-latency benchmark that times every operation, including rehash spikes.
+ *
+ * @section DESCRIPTION
+ * This file times every single operation of insert-heavy, erase-heavy and oscillating sequences
+ * that cross the growth and shrink thresholds of each map layout, with the time stamp counter,
+ * and reports the latency percentiles together with the cost of the operations that rehashed.
+ * It also measures the overhead of a HashMap's own sampled latency histograms (LatencySampler).
+ */
+
+#include <iostream>
+#include <iomanip>
+#include "BenchUtils.hpp"
+#include "Histogram.hpp"
+#include "BenchReport.hpp"
+#include "LatencySampler.hpp"
+
+#define USAGE_MSG "Usage: LatencyBenchmark [entries] [--json <path>]"
+#define BENCHMARK_NAME "LatencyBenchmark"
+#define NS "ns"
+#define DEFAULT_ENTRIES 1000000
+#define ENTRIES_INDEX 1
+#define STRING_KEY_LENGTH 24
+#define WAVES 4
+#define WAVE_LOW_DIVISOR 4
+#define SAMPLING_ROUNDS 5
+#define NAME_WIDTH 16
+#define TYPE_WIDTH 12
+#define NUMBER_WIDTH 11
+
+const double P50 = 0.5, P99 = 0.99, P999 = 0.999, P9999 = 0.9999;
+
+/**
+ * Latencies (in time stamp counter ticks) of a sequence of operations.
+ */
+struct SequenceLatency
+{
+    Histogram all, rehashing;
+    unsigned long long totalTicks = 0, rehashTicks = 0;
+
+    /**
+     * Records an operation that took the given ticks and that did or didn't change the capacity.
+     */
+    void record(unsigned long long ticks, bool rehashed) noexcept
+    {
+        all.record(ticks);
+        totalTicks += ticks;
+        if (rehashed)
+        {
+            rehashing.record(ticks);
+            rehashTicks += ticks;
+        }
+    }
+};
+
+// Times a single operation and records it, noting whether it changed the capacity.
+template<typename Layout, typename Map, typename Operation>
+static void timed(Map &map, SequenceLatency &latency, Operation operation)
+{
+    long long capacity = Layout::capacity(map);
+    unsigned long long start = readTsc();
+    operation();
+    unsigned long long ticks = readTsc() - start;
+    latency.record(ticks, Layout::capacity(map) != capacity);
+}
+
+// Prints a line with the latencies of a sequence.
+template<typename Layout, typename KeyT>
+static void report(BenchReport &results, const char *sequence, int keyLength, const SequenceLatency &latency)
+{
+    double perNanosecond = tscTicksPerNanosecond();
+    auto ns = [perNanosecond](unsigned long long ticks)
+    { return (long long) (ticks / perNanosecond); };
+    std::string name = std::string(Layout::name()) + "/" + BenchData<KeyT>::name(keyLength) + "/" + sequence + "/";
+    results.add(name + "p50", NS, true, ns(latency.all.percentile(P50)));
+    results.add(name + "p99", NS, true, ns(latency.all.percentile(P99)));
+    results.add(name + "p99.9", NS, true, ns(latency.all.percentile(P999)));
+    results.add(name + "max", NS, true, ns(latency.all.max()));
+    std::cout << std::left << std::setw(NAME_WIDTH) << Layout::name()
+              << std::setw(TYPE_WIDTH) << BenchData<KeyT>::name(keyLength) << std::setw(TYPE_WIDTH) << sequence
+              << std::right << std::setw(NUMBER_WIDTH) << latency.all.count()
+              << std::setw(NUMBER_WIDTH) << ns(latency.all.percentile(P50))
+              << std::setw(NUMBER_WIDTH) << ns(latency.all.percentile(P99))
+              << std::setw(NUMBER_WIDTH) << ns(latency.all.percentile(P999))
+              << std::setw(NUMBER_WIDTH) << ns(latency.all.percentile(P9999))
+              << std::setw(NUMBER_WIDTH) << ns(latency.all.max())
+              << std::setw(NUMBER_WIDTH) << latency.rehashing.count()
+              << std::setw(NUMBER_WIDTH) << std::fixed << std::setprecision(1)
+              << (latency.totalTicks ? 100.0 * latency.rehashTicks / latency.totalTicks : 0) << std::endl;
+}
+
+// Runs the insert, erase and wave sequences on a layout with the given keys.
+template<typename Layout, typename KeyT>
+static void measure(BenchReport &results, const std::vector<KeyT> &keys, int keyLength)
+{
+    typedef typename Layout::template Map<KeyT, int> Map;
+    int count = keys.size(), low = count / WAVE_LOW_DIVISOR;
+
+    Map map;
+    SequenceLatency inserts, erases, waves;
+    for (int i = 0; i < count; i++)
+    {
+        timed<Layout>(map, inserts, [&]()
+        { Layout::insert(map, keys[i], i); });
+    }
+    for (int i = 0; i < count; i++)
+    {
+        timed<Layout>(map, erases, [&]()
+        { Layout::erase(map, keys[i]); });
+    }
+
+    // Oscillate between a quarter of the keys and all of them, crossing both thresholds.
+    for (int i = 0; i < low; i++)
+    {
+        Layout::insert(map, keys[i], i);
+    }
+    for (int wave = 0; wave < WAVES; wave++)
+    {
+        for (int i = low; i < count; i++)
+        {
+            timed<Layout>(map, waves, [&]()
+            { Layout::insert(map, keys[i], i); });
+        }
+        for (int i = low; i < count; i++)
+        {
+            timed<Layout>(map, waves, [&]()
+            { Layout::erase(map, keys[i]); });
+        }
+    }
+
+    report<Layout, KeyT>(results, "insert", keyLength, inserts);
+    report<Layout, KeyT>(results, "erase", keyLength, erases);
+    report<Layout, KeyT>(results, "waves", keyLength, waves);
+}
+
+// Times (in ticks) inserting, finding and erasing every key, and returns how many were found.
+template<typename KeyT>
+static long long timeRound(HashMap<KeyT, int> &map, const std::vector<KeyT> &keys, unsigned long long &fastest)
+{
+    long long found = 0;
+    unsigned long long start = readTsc();
+    for (int i = 0; i < (int) keys.size(); i++)
+    {
+        map.insert(keys[i], i);
+    }
+    for (const KeyT &key : keys)
+    {
+        found += map.containsKey(key);
+    }
+    for (const KeyT &key : keys)
+    {
+        map.erase(key);
+    }
+    fastest = std::min(fastest, readTsc() - start);
+    return found;
+}
+
+// Measures the overhead of sampling a HashMap's operations, and prints the sampled latencies.
+template<typename KeyT>
+static void measureSampling(BenchReport &results, const std::vector<KeyT> &keys, int keyLength)
+{
+    HashMap<KeyT, int> plain, sampled;
+    LatencySampler sampler;
+    sampled.setSampler(&sampler);
+    unsigned long long plainTicks = ~0ULL, sampledTicks = ~0ULL;
+    for (int round = 0; round < SAMPLING_ROUNDS; round++) // Alternately, so both see the same noise.
+    {
+        if (timeRound(plain, keys, plainTicks) + timeRound(sampled, keys, sampledTicks) != 2LL * (long long) keys.size())
+        {
+            std::cerr << "A map lost keys." << std::endl;
+        }
+    }
+    double overhead = 100.0 * ((double) sampledTicks / plainTicks - 1);
+    std::string name = std::string("HashMap/") + BenchData<KeyT>::name(keyLength) + "/sampling/";
+    results.add(name + "overhead", "%", true, overhead);
+    std::cout << std::left << std::setw(NAME_WIDTH) << "HashMap" << std::setw(TYPE_WIDTH)
+              << BenchData<KeyT>::name(keyLength) << "sampled 1/" << DEFAULT_SAMPLE_PERIOD << ": overhead "
+              << std::fixed << std::setprecision(2) << overhead << "%";
+    const char *names[] = {"find", "insert", "erase"};
+    for (int operation = SAMPLED_FIND; operation <= SAMPLED_ERASE; operation++)
+    {
+        Histogram histogram = sampler.snapshot((SampledOperation) operation);
+        std::cout << ", " << names[operation] << " p50/p99 " << histogram.percentile(P50) << "/"
+                  << histogram.percentile(P99) << " ns (" << histogram.count() << " samples)";
+        results.add(name + names[operation] + "/p99", NS, true, histogram.percentile(P99));
+    }
+    std::cout << std::endl;
+}
+
+// Measures every layout with the given key type.
+template<typename KeyT>
+static void measureAll(BenchReport &results, int count, int keyLength)
+{
+    std::vector<KeyT> keys = benchItems<KeyT>(count, keyLength);
+    measure<ChainedLayout>(results, keys, keyLength);
+    measure<StdLayout>(results, keys, keyLength);
+    measureSampling(results, keys, keyLength);
+}
+
+/**
+ * Program's main that receives an optional entry count and prints the latency percentiles (in
+ * nanoseconds) of every sequence on every layout, with how many operations rehashed and the
+ * share of the total time they took.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    BenchReport results(BENCHMARK_NAME, argc, argv);
+    int count = (argc > ENTRIES_INDEX) ? std::atoi(argv[ENTRIES_INDEX]) : DEFAULT_ENTRIES;
+    if (argc > ENTRIES_INDEX + 1 || count <= 0)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::left << std::setw(NAME_WIDTH) << "layout" << std::setw(TYPE_WIDTH) << "key"
+              << std::setw(TYPE_WIDTH) << "sequence" << std::right << std::setw(NUMBER_WIDTH) << "ops"
+              << std::setw(NUMBER_WIDTH) << "p50 ns" << std::setw(NUMBER_WIDTH) << "p99 ns"
+              << std::setw(NUMBER_WIDTH) << "p99.9 ns" << std::setw(NUMBER_WIDTH) << "p99.99 ns"
+              << std::setw(NUMBER_WIDTH) << "max ns" << std::setw(NUMBER_WIDTH) << "rehashes"
+              << std::setw(NUMBER_WIDTH) << "rehash %" << std::endl;
+
+    measureAll<long long>(results, count, 0);
+    measureAll<std::string>(results, count, STRING_KEY_LENGTH);
+    return results.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
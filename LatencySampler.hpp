@@ -0,0 +1,306 @@
+/**
+ * @file LatencySampler.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Sampled latency histograms of map operations, for use in production.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for a latency sampler: a map that is given one times
+ * about one in every N of its operations with the time stamp counter, and records the times in a
+ * log-linear histogram per operation type. Every thread records into histograms of its own, so
+ * recording never contends, and a snapshot merges them. Operations that aren't sampled only
+ * count down a thread-local counter of their sampler. The histograms of a thread that exits are
+ * kept, and handed to the next thread that starts sampling.
+ */
+
+#ifndef SPAMDETECTOR_LATENCYSAMPLER_HPP
+#define SPAMDETECTOR_LATENCYSAMPLER_HPP
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include "Histogram.hpp"
+
+#define DEFAULT_SAMPLE_PERIOD 256
+#define LOCAL_SAMPLERS 4
+
+/**
+ * The types of operations that a LatencySampler keeps apart.
+ */
+enum SampledOperation
+{
+    SAMPLED_FIND, SAMPLED_INSERT, SAMPLED_ERASE, SAMPLED_ITERATE, SAMPLED_OPERATIONS
+};
+
+/**
+ * Per-thread latency histograms (in nanoseconds) of sampled map operations.
+ * Can be shared by many maps and threads; it must outlive its use by them.
+ */
+class LatencySampler
+{
+    // The histograms of one thread, claimed by it until it exits.
+    struct _Shard
+    {
+        std::atomic<bool> claimed;
+        std::mutex mutex; // Only contended by snapshot() and clear().
+        Histogram histograms[SAMPLED_OPERATIONS];
+    };
+
+    // A sampler's state in one thread: the distance to its next sample, and its shard once it has one.
+    struct _Local
+    {
+        unsigned long long sampler;
+        int countdown;
+        _Shard *shard;
+    };
+
+    // The states of the last LOCAL_SAMPLERS samplers a thread used, and its random state.
+    struct _ThreadState
+    {
+        _Local locals[LOCAL_SAMPLERS];
+        unsigned int next; // The state to replace when another sampler is used.
+        unsigned int random;
+    };
+
+    // The shards a thread claimed, by sampler, which it releases for reuse when it exits.
+    struct _Holder
+    {
+        std::vector<std::pair<unsigned long long, std::shared_ptr<_Shard>>> shards;
+
+        ~_Holder()
+        {
+            for (auto &held : shards)
+            {
+                held.second->claimed.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    int _period;
+    double _nanosecondsPerTick;
+    unsigned long long _id;
+    mutable std::mutex _mutex;
+    std::vector<std::shared_ptr<_Shard>> _shards;
+
+    // Returns the calling thread's sampling state.
+    static _ThreadState &_state() noexcept
+    {
+        static thread_local _ThreadState state = {{}, 0, 0x9e3779b9u};
+        return state;
+    }
+
+    // Returns the calling thread's state of this sampler.
+    _Local &_local() const noexcept
+    {
+        for (_Local &local : _state().locals)
+        {
+            if (local.sampler == _id)
+            {
+                return local;
+            }
+        }
+        return _replaceLocal();
+    }
+
+    // Gives this sampler the calling thread's least recently added state (out of line, as it's rare).
+    __attribute__((noinline)) _Local &_replaceLocal() const noexcept
+    {
+        _ThreadState &state = _state();
+        _Local &local = state.locals[state.next++ % LOCAL_SAMPLERS];
+        local = {_id, 0, nullptr};
+        _drawCountdown(local);
+        return local;
+    }
+
+    // Draws the distance to the next sample of a state (out of line, to keep the check small).
+    __attribute__((noinline)) void _drawCountdown(_Local &local) const noexcept
+    {
+        unsigned int &random = _state().random;
+        random ^= random << 13; // xorshift32.
+        random ^= random >> 17;
+        random ^= random << 5;
+        local.countdown = (_period == 1) ? 1 : 1 + (int) (random % (2 * _period - 1));
+    }
+
+    // Returns the shard of the calling thread, claiming one on the thread's first sample.
+    _Shard &_localShard()
+    {
+        _Local &local = _local();
+        if (local.shard == nullptr)
+        {
+            local.shard = &_claimShard();
+        }
+        return *local.shard;
+    }
+
+    // Returns the shard the calling thread holds, or else claims one that an exited thread released
+    // or a new one. Shards of samplers that are gone are dropped meanwhile.
+    _Shard &_claimShard()
+    {
+        static thread_local _Holder holder;
+        auto &held = holder.shards;
+        for (auto &entry : held)
+        {
+            if (entry.first == _id)
+            {
+                return *entry.second;
+            }
+        }
+        held.erase(std::remove_if(held.begin(), held.end(),
+                                  [](const std::pair<unsigned long long, std::shared_ptr<_Shard>> &entry)
+                                  { return entry.second.use_count() == 1; }), held.end());
+        held.reserve(held.size() + 1);
+
+        std::shared_ptr<_Shard> shard;
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &existing : _shards)
+        {
+            if (!existing->claimed.exchange(true, std::memory_order_acquire))
+            {
+                shard = existing;
+                break;
+            }
+        }
+        if (shard == nullptr)
+        {
+            shard = std::make_shared<_Shard>();
+            shard->claimed.store(true, std::memory_order_relaxed);
+            _shards.push_back(shard);
+        }
+        held.emplace_back(_id, shard);
+        return *shard;
+    }
+
+public:
+    /**
+     * Creates a sampler of about one in every period operations.
+     *
+     * @param period The mean distance between samples (1 samples every operation).
+     */
+    explicit LatencySampler(int period = DEFAULT_SAMPLE_PERIOD)
+            : _period(std::max(1, period)), _nanosecondsPerTick(1 / tscTicksPerNanosecond())
+    {
+        static std::atomic<unsigned long long> ids(0);
+        _id = ++ids;
+    }
+
+    LatencySampler(const LatencySampler &other) = delete;
+
+    LatencySampler &operator=(const LatencySampler &other) = delete;
+
+    /**
+     * Returns true if the calling thread should time its next operation with this sampler. The
+     * distance between samples is random (with the period as its mean), so periodic workloads are
+     * sampled fairly. Every sampler keeps its own distance in every thread.
+     *
+     * @return True if the next operation should be timed.
+     */
+    bool shouldSample() const noexcept
+    {
+        _Local &local = _local();
+        if (__builtin_expect(--local.countdown > 0, 1))
+        {
+            return false;
+        }
+        _drawCountdown(local);
+        return true;
+    }
+
+    /**
+     * Records a sampled operation into the calling thread's histograms.
+     * Does nothing if the thread's histograms can't be allocated.
+     *
+     * @param operation The operation's type.
+     * @param ticks How many time stamp counter ticks the operation took.
+     */
+    __attribute__((noinline)) void record(SampledOperation operation, unsigned long long ticks) noexcept
+    {
+        try
+        {
+            _Shard &shard = _localShard();
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.histograms[operation].record((unsigned long long) (ticks * _nanosecondsPerTick));
+        }
+        catch (std::exception &)
+        {
+        }
+    }
+
+    /**
+     * Returns the latencies of an operation type, merged from all threads.
+     *
+     * @param operation The operation's type.
+     * @return The latencies (in nanoseconds) of the sampled operations of the given type.
+     */
+    Histogram snapshot(SampledOperation operation) const
+    {
+        Histogram merged;
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &shard : _shards)
+        {
+            std::lock_guard<std::mutex> shardLock(shard->mutex);
+            merged.merge(shard->histograms[operation]);
+        }
+        return merged;
+    }
+
+    /**
+     * Removes all samples.
+     */
+    void clear() noexcept
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &shard : _shards)
+        {
+            std::lock_guard<std::mutex> shardLock(shard->mutex);
+            for (Histogram &histogram : shard->histograms)
+            {
+                histogram.clear();
+            }
+        }
+    }
+};
+
+/**
+ * Times the scope it lives in, if there is a sampler and it chose this operation.
+ */
+class SampleTimer
+{
+    LatencySampler *_sampler;
+    SampledOperation _operation;
+    unsigned long long _start;
+
+public:
+    /**
+     * Starts timing an operation, if sampler isn't nullptr and samples it.
+     *
+     * @param sampler The sampler, or nullptr.
+     * @param operation The operation's type.
+     */
+    SampleTimer(LatencySampler *sampler, SampledOperation operation) noexcept
+            : _sampler((sampler != nullptr && sampler->shouldSample()) ? sampler : nullptr), _operation(operation),
+              _start(_sampler != nullptr ? readTsc() : 0)
+    {}
+
+    SampleTimer(const SampleTimer &other) = delete;
+
+    SampleTimer &operator=(const SampleTimer &other) = delete;
+
+    /**
+     * Records the operation, if it was sampled.
+     */
+    ~SampleTimer()
+    {
+        if (_sampler != nullptr)
+        {
+            _sampler->record(_operation, readTsc() - _start);
+        }
+    }
+};
+
+#endif //SPAMDETECTOR_LATENCYSAMPLER_HPP
@@ -0,0 +1,127 @@
+/**
+ * @file MappedBenchmark.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Benchmark of the file-backed MappedHashMap against the in-memory HashMap.
+ *
+ * @section DESCRIPTION
+ * This file fills a MappedHashMap and a HashMap with the same keys, and reports the insert and
+ * lookup throughput of both, the time to sync the files, and the time to reopen the mapped
+ * map and look up every key against the time to rebuild the in-memory one.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include "BenchUtils.hpp"
+#include "BenchReport.hpp"
+#include "MappedHashMap.hpp"
+
+#define USAGE_MSG "Usage: MappedBenchmark [entries] [--json <path>]"
+#define BENCHMARK_NAME "MappedBenchmark"
+#define TEMP_TEMPLATE "/tmp/MappedBenchmarkXXXXXX"
+#define DATA_FILE "/map"
+#define ENTRIES_INDEX 1
+#define DEFAULT_ENTRIES 2000000
+#define NAME_WIDTH 24
+#define NUMBER_WIDTH 14
+
+// Returns the milliseconds since the given time.
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Prints and records a line of results.
+static void print(BenchReport &report, const std::string &name, const char *unit, bool lowerIsBetter, double value)
+{
+    report.add(name, unit, lowerIsBetter, value);
+    std::cout << std::left << std::setw(NAME_WIDTH) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(NUMBER_WIDTH) << value << " " << unit << std::endl;
+}
+
+// Times finding every key, and returns how many were found.
+template<typename Map>
+static long long findAll(BenchReport &report, const std::string &name, const Map &map,
+                         const std::vector<long long> &keys)
+{
+    long long found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long key : keys)
+    {
+        found += map.containsKey(key);
+    }
+    print(report, name, "ns/op", true, millisecondsSince(start) * 1e6 / keys.size());
+    return found;
+}
+
+/**
+ * Program's main that receives an optional entry count and prints the costs of the mapped and
+ * in-memory maps.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    BenchReport report(BENCHMARK_NAME, argc, argv);
+    int count = (argc > ENTRIES_INDEX) ? std::atoi(argv[ENTRIES_INDEX]) : DEFAULT_ENTRIES;
+    char directory[] = TEMP_TEMPLATE;
+    if (argc > ENTRIES_INDEX + 1 || count <= 0 || mkdtemp(directory) == nullptr)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string path = std::string(directory) + DATA_FILE;
+    std::vector<long long> keys = benchItems<long long>(count, 0);
+    long long found = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    HashMap<long long, long long> memory;
+    for (int i = 0; i < count; i++)
+    {
+        memory.insert(keys[i], i);
+    }
+    print(report, "HashMap/build", "ms", true, millisecondsSince(start));
+    found += findAll(report, "HashMap/find", memory, keys);
+
+    try
+    {
+        {
+            start = std::chrono::steady_clock::now();
+            MappedHashMap<long long, long long> mapped(path);
+            for (int i = 0; i < count; i++)
+            {
+                mapped.insert(keys[i], i);
+            }
+            print(report, "MappedHashMap/build", "ms", true, millisecondsSince(start));
+            found += findAll(report, "MappedHashMap/find", mapped, keys);
+            start = std::chrono::steady_clock::now();
+            mapped.sync();
+            print(report, "MappedHashMap/sync", "ms", true, millisecondsSince(start));
+        }
+
+        start = std::chrono::steady_clock::now();
+        MappedHashMap<long long, long long> reopened(path);
+        print(report, "MappedHashMap/reopen", "ms", true, millisecondsSince(start));
+        found += findAll(report, "MappedHashMap/cold find", reopened, keys);
+    }
+    catch (MappedFileException &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    unlink(path.c_str());
+    unlink((path + INDEX_SUFFIX).c_str());
+    rmdir(directory);
+    if (found != 3LL * count)
+    {
+        std::cerr << "A map lost keys." << std::endl;
+        return EXIT_FAILURE;
+    }
+    return report.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,629 @@
+/**
+ * @file MappedHashMap.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief A writable HashMap whose buckets and entries live in memory-mapped files.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for the MappedHashMap class. The entries live in one
+ * file and the bucket heads in another, and both grow in place with ftruncate and mremap. The OS
+ * writes dirty pages back on its own and keeps only the working set in memory, so maps can be
+ * larger than RAM and reopen without a load step.
+ */
+
+#ifndef SPAMDETECTOR_MAPPEDHASHMAP_HPP
+#define SPAMDETECTOR_MAPPEDHASHMAP_HPP
+
+#include <string>
+#include <cstring>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "HashMap.hpp"
+
+#define MAPPED_MAGIC 0x4d48534d41505032ULL
+#define INDEX_SUFFIX ".index"
+#define NO_ENTRY 0
+#define ERROR_MAPPED_OPEN "ERROR: Can't open the MappedHashMap files, or they aren't valid ones."
+#define ERROR_MAPPED_GROW "ERROR: Can't grow the MappedHashMap files."
+#define ERROR_MAPPED_SYNC "ERROR: Can't mark the MappedHashMap index as changed on disk."
+
+/**
+ * Exception for failures of the files of a MappedHashMap.
+ */
+class MappedFileException : public HashMapException
+{
+    const char *_message;
+
+public:
+    explicit MappedFileException(const char *message) noexcept : _message(message) {}
+
+    const char *what() const noexcept override
+    {
+        return _message;
+    }
+};
+
+/**
+ * Map with chained buckets in two memory-mapped files: "<path>" holds a header and the entries,
+ * and "<path>.index" holds the bucket heads. Chains link entries by index, so nothing refers to
+ * an address. Erased entries are kept on a free list and reused.
+ *
+ * Growth doubles the bucket array in place and splits every bucket i into buckets i and
+ * i + old capacity by the next bit of the stored hash, without moving any entry. The files never
+ * shrink.
+ *
+ * The index is marked dirty, on disk, before the first change after a sync(), and clean once
+ * sync() flushed the changes. If a process dies (or the machine loses power) with a dirty index,
+ * the next open rebuilds the index from the entries.
+ *
+ * Entries are linked by 64-bit indices, so the number of entries is bounded only by the files.
+ *
+ * References returned by at() are valid until the next insertion.
+ *
+ * @tparam KeyT The key type (trivially copyable, with a std::hash that is stable across runs).
+ * @tparam ValueT The value type (trivially copyable).
+ */
+template<typename KeyT, typename ValueT>
+class MappedHashMap
+{
+    static_assert(std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<ValueT>::value,
+                  "MappedHashMap stores keys and values as raw bytes.");
+
+    // A link to an entry: its index plus one (NO_ENTRY ends a chain).
+    typedef unsigned long long Link;
+
+    // The start of the entries file.
+    struct Header
+    {
+        unsigned long long magic, keySize, valueSize;
+        unsigned long long size, entryCapacity, entriesUsed, buckets;
+        Link freeHead;
+        unsigned long long dirty;
+    };
+
+    // An entry, linked to the next one of its chain (or of the free list).
+    struct Entry
+    {
+        unsigned long long hash;
+        Link next;
+        unsigned int full;
+        KeyT key;
+        ValueT value;
+    };
+
+    // Maps (or remaps, after growth) a file of the given size.
+    static void *_remap(void *old, size_t oldBytes, int fd, size_t bytes);
+
+    static size_t _entryBytes(unsigned long long capacity) noexcept
+    {
+        return sizeof(Header) + capacity * sizeof(Entry);
+    }
+
+    Entry &_entry(Link link) const noexcept
+    {
+        return reinterpret_cast<Entry *>(_header + 1)[link - 1];
+    }
+
+    unsigned long long _bucket(unsigned long long hash) const noexcept
+    {
+        return hash & (_header->buckets - 1);
+    }
+
+    // Returns the entry with the given key, or nullptr.
+    Entry *_find(const KeyT &key) const noexcept;
+
+    // Marks the index dirty before the first change after a sync. The mark is written to disk
+    // first, so that no page of the change can reach the disk before it.
+    void _touch()
+    {
+        if (_header->dirty == 0)
+        {
+            _header->dirty = 1;
+            if (msync(_header, sizeof(Header), MS_SYNC) != 0)
+            {
+                _header->dirty = 0;
+                throw MappedFileException(ERROR_MAPPED_SYNC);
+            }
+        }
+    }
+
+    // Doubles the entry storage.
+    void _growEntries();
+
+    // Doubles the bucket array and splits every bucket.
+    void _growBuckets();
+
+    // Rebuilds every chain from the full entries (after a crash with a dirty index).
+    void _rebuildIndex();
+
+    // Opens an existing map from its files.
+    void _open(size_t entriesBytes, size_t indexBytes);
+
+    // Unmaps and closes the files.
+    void _release() noexcept;
+
+    int _entriesFd = -1, _indexFd = -1;
+    Header *_header = nullptr;
+    Link *_heads = nullptr;
+
+public:
+    /**
+     * Opens the map stored at the given path, creating an empty one if it doesn't exist.
+     *
+     * @param path The path of the entries file (the index is "<path>.index").
+     * @throws MappedFileException if the files can't be opened or aren't a map of these types.
+     */
+    explicit MappedHashMap(const std::string &path);
+
+    MappedHashMap(const MappedHashMap &) = delete;
+
+    MappedHashMap &operator=(const MappedHashMap &) = delete;
+
+    /**
+     * Destructor for MappedHashMap. Syncs the files and unmaps them.
+     */
+    ~MappedHashMap() noexcept;
+
+    /**
+     * Returns how many elements are currently in this map.
+     *
+     * @return How many elements are currently in this map.
+     */
+    long long size() const noexcept
+    {
+        return _header->size;
+    }
+
+    /**
+     * Returns the current number of buckets of this map.
+     *
+     * @return The current number of buckets of this map.
+     */
+    long long capacity() const noexcept
+    {
+        return _header->buckets;
+    }
+
+    /**
+     * Returns true if there no elements in this map. Otherwise, returns false.
+     *
+     * @return True if there no elements in this map. Otherwise, returns false.
+     */
+    bool empty() const noexcept
+    {
+        return _header->size == 0;
+    }
+
+    /**
+     * Returns true if this map contains the given key. Otherwise, returns false.
+     *
+     * @param key The key to find.
+     * @return True if this map contains the given key. Otherwise, returns false.
+     */
+    bool containsKey(const KeyT &key) const noexcept
+    {
+        return _find(key) != nullptr;
+    }
+
+    /**
+     * Returns the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception.
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @throws MappedFileException if the index can't be marked dirty on disk.
+     * @return The value paired with the given key.
+     */
+    ValueT &at(const KeyT &key);
+
+    /**
+     * Returns the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception. (Const version)
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return The value paired with the given key.
+     */
+    const ValueT &at(const KeyT &key) const;
+
+    /**
+     * Returns true if insertion to this map is successful. Otherwise returns false.
+     * Failure to insert happens when key already exists in this map.
+     *
+     * @param key The key to insert.
+     * @param value The value to insert.
+     * @throws MappedFileException if the files can't grow, or the index can't be marked dirty on disk.
+     * @return True if insertion to this map is successful. Otherwise returns false.
+     */
+    bool insert(const KeyT &key, const ValueT &value);
+
+    /**
+     * Returns true if given key was found in this map and erases it. Otherwise, returns false.
+     *
+     * @param key The key to erase.
+     * @throws MappedFileException if the index can't be marked dirty on disk.
+     * @return True if given key was found in this map and erases it. Otherwise, returns false.
+     */
+    bool erase(const KeyT &key);
+
+    /**
+     * Clears this map from all elements, while not changing the capacity.
+     *
+     * @throws MappedFileException if the index can't be marked dirty on disk.
+     */
+    void clear();
+
+    /**
+     * Writes all changes to the files and waits for them, then marks the index clean.
+     *
+     * @return True if the files were synced. Otherwise, returns false.
+     */
+    bool sync() noexcept;
+};
+
+// Private helper function that maps a file for reading and writing, moving an old mapping.
+template<typename KeyT, typename ValueT>
+void *MappedHashMap<KeyT, ValueT>::_remap(void *old, size_t oldBytes, int fd, size_t bytes)
+{
+    void *mapped = (old == nullptr) ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                    : mremap(old, oldBytes, bytes, MREMAP_MAYMOVE);
+    if (mapped == MAP_FAILED)
+    {
+        throw MappedFileException(ERROR_MAPPED_GROW);
+    }
+    return mapped;
+}
+
+// Private method that walks the chain of the key's bucket.
+template<typename KeyT, typename ValueT>
+typename MappedHashMap<KeyT, ValueT>::Entry *MappedHashMap<KeyT, ValueT>::_find(const KeyT &key) const noexcept
+{
+    unsigned long long hash = std::hash<KeyT>{}(key);
+    for (Link link = _heads[_bucket(hash)]; link != NO_ENTRY; link = _entry(link).next)
+    {
+        Entry &entry = _entry(link);
+        if (entry.hash == hash && entry.key == key)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+// Private method that doubles the entries file. Entries keep their indices.
+template<typename KeyT, typename ValueT>
+void MappedHashMap<KeyT, ValueT>::_growEntries()
+{
+    unsigned long long capacity = _header->entryCapacity;
+    size_t oldBytes = _entryBytes(capacity), bytes = _entryBytes(capacity * CHANGE_FACTOR);
+    if (ftruncate(_entriesFd, bytes) != 0)
+    {
+        throw MappedFileException(ERROR_MAPPED_GROW);
+    }
+    _header = static_cast<Header *>(_remap(_header, oldBytes, _entriesFd, bytes));
+    _header->entryCapacity = capacity * CHANGE_FACTOR;
+}
+
+// Private method that doubles the bucket array in place and splits each bucket by the new bit.
+template<typename KeyT, typename ValueT>
+void MappedHashMap<KeyT, ValueT>::_growBuckets()
+{
+    unsigned long long old = _header->buckets;
+    size_t bytes = old * CHANGE_FACTOR * sizeof(Link);
+    if (ftruncate(_indexFd, bytes) != 0)
+    {
+        throw MappedFileException(ERROR_MAPPED_GROW);
+    }
+    _heads = static_cast<Link *>(_remap(_heads, old * sizeof(Link), _indexFd, bytes));
+
+    for (unsigned long long i = 0; i < old; i++)
+    {
+        Link low = NO_ENTRY, high = NO_ENTRY, *lowTail = &low, *highTail = &high;
+        for (Link link = _heads[i]; link != NO_ENTRY; link = _entry(link).next)
+        {
+            Link *&tail = (_entry(link).hash & old) ? highTail : lowTail;
+            *tail = link;
+            tail = &_entry(link).next;
+        }
+        *lowTail = NO_ENTRY;
+        *highTail = NO_ENTRY;
+        _heads[i] = low;
+        _heads[i + old] = high;
+    }
+    _header->buckets = old * CHANGE_FACTOR;
+}
+
+// Private method that relinks every full entry into a cleared index, and every other into the free list.
+template<typename KeyT, typename ValueT>
+void MappedHashMap<KeyT, ValueT>::_rebuildIndex()
+{
+    std::memset(_heads, 0, _header->buckets * sizeof(Link));
+    _header->freeHead = NO_ENTRY;
+    _header->size = 0;
+    for (Link link = _header->entriesUsed; link != NO_ENTRY; link--)
+    {
+        Entry &entry = _entry(link);
+        Link &head = entry.full ? _heads[_bucket(entry.hash)] : _header->freeHead;
+        entry.next = head;
+        head = link;
+        _header->size += entry.full;
+    }
+    while (_header->size > _header->buckets * MAX_LOAD_FACTOR)
+    {
+        _growBuckets();
+    }
+}
+
+// Private method that maps the files of an existing map and checks them.
+template<typename KeyT, typename ValueT>
+void MappedHashMap<KeyT, ValueT>::_open(size_t entriesBytes, size_t indexBytes)
+{
+    if (entriesBytes < sizeof(Header))
+    {
+        throw MappedFileException(ERROR_MAPPED_OPEN);
+    }
+    _header = static_cast<Header *>(_remap(nullptr, 0, _entriesFd, entriesBytes));
+    if (_header->magic != MAPPED_MAGIC || _header->keySize != sizeof(KeyT) || _header->valueSize != sizeof(ValueT))
+    {
+        munmap(_header, entriesBytes);
+        _header = nullptr;
+        throw MappedFileException(ERROR_MAPPED_OPEN);
+    }
+
+    // A crash during growth can leave either file larger than the header says; cut it back.
+    size_t expected = _entryBytes(_header->entryCapacity), expectedIndex = _header->buckets * sizeof(Link);
+    bool consistent = !_header->dirty && indexBytes == expectedIndex;
+    if (entriesBytes != expected)
+    {
+        void *mapped = (entriesBytes > expected) ? mremap(_header, entriesBytes, expected, MREMAP_MAYMOVE) : MAP_FAILED;
+        if (mapped == MAP_FAILED || ftruncate(_entriesFd, expected) != 0)
+        {
+            munmap(mapped == MAP_FAILED ? (void *) _header : mapped, mapped == MAP_FAILED ? entriesBytes : expected);
+            _header = nullptr;
+            throw MappedFileException(ERROR_MAPPED_OPEN);
+        }
+        _header = static_cast<Header *>(mapped);
+    }
+    if (indexBytes != expectedIndex && ftruncate(_indexFd, expectedIndex) != 0)
+    {
+        throw MappedFileException(ERROR_MAPPED_OPEN);
+    }
+    _heads = static_cast<Link *>(_remap(nullptr, 0, _indexFd, expectedIndex));
+    if (!consistent)
+    {
+        _rebuildIndex();
+    }
+}
+
+// Private method that unmaps and closes the files.
+template<typename KeyT, typename ValueT>
+void MappedHashMap<KeyT, ValueT>::_release() noexcept
+{
+    if (_heads != nullptr)
+    {
+        munmap(_heads, _header->buckets * sizeof(Link));
+    }
+    if (_header != nullptr)
+    {
+        munmap(_header, _entryBytes(_header->entryCapacity));
+    }
+    if (_entriesFd >= 0)
+    {
+        close(_entriesFd);
+    }
+    if (_indexFd >= 0)
+    {
+        close(_indexFd);
+    }
+    _header = nullptr;
+    _heads = nullptr;
+    _entriesFd = _indexFd = -1;
+}
+
+/**
+ * Opens the map stored at the given path, creating an empty one if it doesn't exist.
+ *
+ * @param path The path of the entries file (the index is "<path>.index").
+ * @throws MappedFileException if the files can't be opened or aren't a map of these types.
+ */
+template<typename KeyT, typename ValueT>
+MappedHashMap<KeyT, ValueT>::MappedHashMap(const std::string &path)
+{
+    _entriesFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    _indexFd = ::open((path + INDEX_SUFFIX).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    struct stat entriesStatus, indexStatus;
+    try
+    {
+        if (_entriesFd < 0 || _indexFd < 0 || fstat(_entriesFd, &entriesStatus) != 0 ||
+            fstat(_indexFd, &indexStatus) != 0)
+        {
+            throw MappedFileException(ERROR_MAPPED_OPEN);
+        }
+        if (entriesStatus.st_size != 0)
+        {
+            _open(entriesStatus.st_size, indexStatus.st_size);
+            return;
+        }
+
+        // A new map.
+        if (ftruncate(_entriesFd, _entryBytes(DEFAULT_CAPACITY)) != 0 ||
+            ftruncate(_indexFd, DEFAULT_CAPACITY * sizeof(Link)) != 0)
+        {
+            throw MappedFileException(ERROR_MAPPED_OPEN);
+        }
+        _header = static_cast<Header *>(_remap(nullptr, 0, _entriesFd, _entryBytes(DEFAULT_CAPACITY)));
+        *_header = Header{MAPPED_MAGIC, sizeof(KeyT), sizeof(ValueT), 0, DEFAULT_CAPACITY, 0, DEFAULT_CAPACITY,
+                          NO_ENTRY, 0};
+        _heads = static_cast<Link *>(_remap(nullptr, 0, _indexFd, DEFAULT_CAPACITY * sizeof(Link)));
+    }
+    catch (MappedFileException &)
+    {
+        _release();
+        throw;
+    }
+}
+
+/**
+ * Destructor for MappedHashMap. Syncs the files and unmaps them.
+ */
+template<typename KeyT, typename ValueT>
+MappedHashMap<KeyT, ValueT>::~MappedHashMap() noexcept
+{
+    sync();
+    _release();
+}
+
+/**
+ * Returns the value paired with the given key, if it is in this map.
+ * Otherwise, throws exception.
+ *
+ * @param key The key to find.
+ * @throws KeyNotFoundException if key isn't in this map.
+ * @throws MappedFileException if the index can't be marked dirty on disk.
+ * @return The value paired with the given key.
+ */
+template<typename KeyT, typename ValueT>
+ValueT &MappedHashMap<KeyT, ValueT>::at(const KeyT &key)
+{
+    Entry *entry = _find(key);
+    if (entry == nullptr)
+    {
+        throw KeyNotFoundException();
+    }
+    _touch();
+    return entry->value;
+}
+
+/**
+ * Returns the value paired with the given key, if it is in this map.
+ * Otherwise, throws exception. (Const version)
+ *
+ * @param key The key to find.
+ * @throws KeyNotFoundException if key isn't in this map.
+ * @return The value paired with the given key.
+ */
+template<typename KeyT, typename ValueT>
+const ValueT &MappedHashMap<KeyT, ValueT>::at(const KeyT &key) const
+{
+    Entry *entry = _find(key);
+    if (entry == nullptr)
+    {
+        throw KeyNotFoundException();
+    }
+    return entry->value;
+}
+
+/**
+ * Returns true if insertion to this map is successful. Otherwise returns false.
+ * Failure to insert happens when key already exists in this map.
+ *
+ * @param key The key to insert.
+ * @param value The value to insert.
+ * @throws MappedFileException if the files can't grow, or the index can't be marked dirty on disk.
+ * @return True if insertion to this map is successful. Otherwise returns false.
+ */
+template<typename KeyT, typename ValueT>
+bool MappedHashMap<KeyT, ValueT>::insert(const KeyT &key, const ValueT &value)
+{
+    if (_find(key) != nullptr)
+    {
+        return false;
+    }
+    _touch();
+    if (_header->freeHead == NO_ENTRY && _header->entriesUsed == _header->entryCapacity)
+    {
+        _growEntries();
+    }
+
+    Link link = _header->freeHead;
+    if (link != NO_ENTRY)
+    {
+        _header->freeHead = _entry(link).next;
+    }
+    else
+    {
+        link = ++_header->entriesUsed;
+    }
+
+    Entry &entry = _entry(link);
+    entry.hash = std::hash<KeyT>{}(key);
+    entry.key = key;
+    entry.value = value;
+    entry.full = 1;
+    entry.next = _heads[_bucket(entry.hash)];
+    _heads[_bucket(entry.hash)] = link;
+    _header->size++;
+    if (_header->size > _header->buckets * MAX_LOAD_FACTOR)
+    {
+        _growBuckets();
+    }
+    return true;
+}
+
+/**
+ * Returns true if given key was found in this map and erases it. Otherwise, returns false.
+ *
+ * @param key The key to erase.
+ * @throws MappedFileException if the index can't be marked dirty on disk.
+ * @return True if given key was found in this map and erases it. Otherwise, returns false.
+ */
+template<typename KeyT, typename ValueT>
+bool MappedHashMap<KeyT, ValueT>::erase(const KeyT &key)
+{
+    unsigned long long hash = std::hash<KeyT>{}(key);
+    for (Link *link = &_heads[_bucket(hash)]; *link != NO_ENTRY; link = &_entry(*link).next)
+    {
+        Entry &entry = _entry(*link);
+        if (entry.hash == hash && entry.key == key)
+        {
+            _touch();
+            Link erased = *link;
+            *link = entry.next;
+            entry.full = 0;
+            entry.next = _header->freeHead;
+            _header->freeHead = erased;
+            _header->size--;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Clears this map from all elements, while not changing the capacity.
+ *
+ * @throws MappedFileException if the index can't be marked dirty on disk.
+ */
+template<typename KeyT, typename ValueT>
+void MappedHashMap<KeyT, ValueT>::clear()
+{
+    _touch();
+    std::memset(_heads, 0, _header->buckets * sizeof(Link));
+    _header->entriesUsed = 0;
+    _header->freeHead = NO_ENTRY;
+    _header->size = 0;
+}
+
+/**
+ * Writes all changes to the files and waits for them, then marks the index clean.
+ *
+ * @return True if the files were synced. Otherwise, returns false.
+ */
+template<typename KeyT, typename ValueT>
+bool MappedHashMap<KeyT, ValueT>::sync() noexcept
+{
+    size_t entryBytes = _entryBytes(_header->entryCapacity), indexBytes = _header->buckets * sizeof(Link);
+    if (msync(_header, entryBytes, MS_SYNC) != 0 || msync(_heads, indexBytes, MS_SYNC) != 0)
+    {
+        return false;
+    }
+    _header->dirty = 0; // Only after everything it vouches for is on disk.
+    return msync(_header, sizeof(Header), MS_SYNC) == 0;
+}
+
+#endif //SPAMDETECTOR_MAPPEDHASHMAP_HPP
@@ -0,0 +1,475 @@
+/**
+ * @file Matcher.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Pluggable phrase matching engines for scoring text against a phrase database.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for the Matcher interface, its engines and the
+ * selector that picks an engine according to the shape of a phrase database.
+ */
+
+#ifndef SPAMDETECTOR_MATCHER_HPP
+#define SPAMDETECTOR_MATCHER_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "HashMap.hpp"
+
+#define SUBSTRING_MAX_PHRASES 8
+#define AUTOMATON_MAX_TABLE_BYTES (64 * 1024 * 1024)
+#define HASHING_MAX_LENGTHS 16
+#define ALPHABET_SIZE 256
+#define ROOT_STATE 0
+#define NO_STATE -1
+#define SUBSTRING_NAME "substring"
+#define AUTOMATON_NAME "automaton"
+#define HASHING_NAME "hashing"
+
+const unsigned long long ROLLING_BASE = 0x100000001b3ULL;
+
+/**
+ * Abstract engine that scores a line of text against a phrase database.
+ *
+ * All engines give the same score: phrases are taken in the database's iteration order and each
+ * phrase scores its leftmost non-overlapping occurrences that weren't already consumed by an
+ * earlier phrase. This is the same as replacing every match with a separator before looking for
+ * the next one.
+ */
+class Matcher
+{
+public:
+    /**
+     * Destructor for Matcher.
+     */
+    virtual ~Matcher() = default;
+
+    /**
+     * Returns the score of the given (lowercase) line.
+     *
+     * @param line The line to score.
+     * @return The sum of the scores of all phrases found in the line.
+     */
+    virtual int score(const std::string &line) const = 0;
+
+    /**
+     * Returns the name of this engine.
+     *
+     * @return The name of this engine.
+     */
+    virtual const char *name() const noexcept = 0;
+};
+
+/**
+ * Base class for engines that hold the phrases of a database in its iteration order.
+ */
+class PhraseMatcher : public Matcher
+{
+protected:
+    std::vector<std::string> _phrases;
+    std::vector<int> _scores;
+
+    /**
+     * Copies the non-empty phrases of the database in iteration order.
+     *
+     * @param database A HashMap that maps from phrases to scores.
+     */
+    explicit PhraseMatcher(const HashMap<std::string, int> &database)
+    {
+        for (const std::pair<std::string, int> &pair : database)
+        {
+            if (!pair.first.empty())
+            {
+                _phrases.push_back(pair.first);
+                _scores.push_back(pair.second);
+            }
+        }
+    }
+
+    /*
+     * Scores all occurrences found in a line, given as (phrase index, start) pairs.
+     * Occurrences are taken by phrase order and then left to right, and an occurrence is only
+     * scored if none of its characters were consumed by a previously scored one.
+     */
+    int _resolve(std::vector<std::pair<int, int>> &matches, int length) const
+    {
+        std::sort(matches.begin(), matches.end());
+        std::vector<char> consumed(length, false);
+        int score = 0;
+        for (const std::pair<int, int> &match : matches)
+        {
+            int start = match.second, end = start + (int) _phrases[match.first].size();
+            if (std::find(consumed.begin() + start, consumed.begin() + end, true) == consumed.begin() + end)
+            {
+                std::fill(consumed.begin() + start, consumed.begin() + end, true);
+                score += _scores[match.first];
+            }
+        }
+        return score;
+    }
+};
+
+/**
+ * Engine that searches each phrase separately with std::string::find.
+ * Best for a few (possibly long) phrases, since find is backed by the library's vectorized memchr.
+ */
+class SubstringMatcher : public PhraseMatcher
+{
+public:
+    /**
+     * Creates a new SubstringMatcher for the given database.
+     *
+     * @param database A HashMap that maps from phrases to scores.
+     */
+    explicit SubstringMatcher(const HashMap<std::string, int> &database) : PhraseMatcher(database) {}
+
+    /**
+     * Returns the score of the given (lowercase) line.
+     *
+     * @param line The line to score.
+     * @return The sum of the scores of all phrases found in the line.
+     */
+    int score(const std::string &line) const override
+    {
+        std::string text(line);
+        int score = 0, count = _phrases.size();
+        for (int i = 0; i < count; i++)
+        {
+            const std::string &phrase = _phrases[i];
+            std::string::size_type index = text.find(phrase);
+            while (index != std::string::npos)
+            {
+                text.replace(index, phrase.size(), 1, '\0'); // Separator that no phrase contains.
+                score += _scores[i];
+                index = text.find(phrase, index + 1);
+            }
+        }
+        return score;
+    }
+
+    /**
+     * Returns the name of this engine.
+     *
+     * @return The name of this engine.
+     */
+    const char *name() const noexcept override
+    {
+        return SUBSTRING_NAME;
+    }
+};
+
+/**
+ * Engine that finds all phrases in a single pass using an Aho-Corasick automaton.
+ * The transition table is dense over the phrases' alphabet, so it suits many short phrases.
+ */
+class AutomatonMatcher : public PhraseMatcher
+{
+    int _alphabet, _states;
+    std::vector<int> _class, _next, _terminal, _dictLink;
+
+public:
+    /**
+     * Creates a new AutomatonMatcher for the given database.
+     *
+     * @param database A HashMap that maps from phrases to scores.
+     */
+    explicit AutomatonMatcher(const HashMap<std::string, int> &database);
+
+    /**
+     * Returns the score of the given (lowercase) line.
+     *
+     * @param line The line to score.
+     * @return The sum of the scores of all phrases found in the line.
+     */
+    int score(const std::string &line) const override;
+
+    /**
+     * Returns the name of this engine.
+     *
+     * @return The name of this engine.
+     */
+    const char *name() const noexcept override
+    {
+        return AUTOMATON_NAME;
+    }
+};
+
+/**
+ * Engine that slides a rolling hash over the line once per distinct phrase length and looks the
+ * windows up in a HashMap. Best when phrases share only a few distinct lengths (e.g. single words).
+ */
+class HashingMatcher : public PhraseMatcher
+{
+    std::vector<int> _lengths;
+    std::vector<unsigned long long> _powers;
+    std::vector<HashMap<unsigned long long, std::vector<int>>> _tables;
+
+    // Scrambles a rolling hash so that its low bits can be used as a bucket index.
+    static unsigned long long _mix(unsigned long long hash) noexcept
+    {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+public:
+    /**
+     * Creates a new HashingMatcher for the given database.
+     *
+     * @param database A HashMap that maps from phrases to scores.
+     */
+    explicit HashingMatcher(const HashMap<std::string, int> &database);
+
+    /**
+     * Returns the score of the given (lowercase) line.
+     *
+     * @param line The line to score.
+     * @return The sum of the scores of all phrases found in the line.
+     */
+    int score(const std::string &line) const override;
+
+    /**
+     * Returns the name of this engine.
+     *
+     * @return The name of this engine.
+     */
+    const char *name() const noexcept override
+    {
+        return HASHING_NAME;
+    }
+};
+
+/**
+ * Creates a new AutomatonMatcher for the given database.
+ *
+ * @param database A HashMap that maps from phrases to scores.
+ */
+inline AutomatonMatcher::AutomatonMatcher(const HashMap<std::string, int> &database) :
+        PhraseMatcher(database), _alphabet(1), _states(1), _class(ALPHABET_SIZE, 0)
+{
+    // Compress the alphabet to the characters that appear in phrases (class 0 is everything else).
+    for (const std::string &phrase : _phrases)
+    {
+        for (char ch : phrase)
+        {
+            int &cls = _class[(unsigned char) ch];
+            if (cls == 0)
+            {
+                cls = _alphabet++;
+            }
+        }
+    }
+
+    // Build the trie.
+    _next.assign(_alphabet, NO_STATE);
+    _terminal.push_back(NO_STATE);
+    int count = _phrases.size();
+    for (int i = 0; i < count; i++)
+    {
+        int state = ROOT_STATE;
+        for (char ch : _phrases[i])
+        {
+            int &next = _next[state * _alphabet + _class[(unsigned char) ch]];
+            if (next == NO_STATE)
+            {
+                next = _states++;
+                _next.resize(_states * _alphabet, NO_STATE);
+                _terminal.push_back(NO_STATE);
+            }
+            state = _next[state * _alphabet + _class[(unsigned char) ch]];
+        }
+        _terminal[state] = i;
+    }
+
+    // Complete the transitions and link each state to the nearest terminal proper suffix (BFS).
+    std::vector<int> fail(_states, ROOT_STATE), queue;
+    _dictLink.assign(_states, NO_STATE);
+    for (int c = 0; c < _alphabet; c++)
+    {
+        int &next = _next[c];
+        if (next == NO_STATE)
+        {
+            next = ROOT_STATE;
+        }
+        else
+        {
+            queue.push_back(next);
+        }
+    }
+    for (int head = 0; head < (int) queue.size(); head++)
+    {
+        int state = queue[head], suffix = fail[state];
+        _dictLink[state] = (_terminal[suffix] != NO_STATE) ? suffix : _dictLink[suffix];
+        for (int c = 0; c < _alphabet; c++)
+        {
+            int &next = _next[state * _alphabet + c];
+            if (next == NO_STATE)
+            {
+                next = _next[suffix * _alphabet + c];
+            }
+            else
+            {
+                fail[next] = _next[suffix * _alphabet + c];
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+/**
+ * Returns the score of the given (lowercase) line.
+ *
+ * @param line The line to score.
+ * @return The sum of the scores of all phrases found in the line.
+ */
+inline int AutomatonMatcher::score(const std::string &line) const
+{
+    std::vector<std::pair<int, int>> matches;
+    int state = ROOT_STATE, length = line.size();
+    for (int i = 0; i < length; i++)
+    {
+        state = _next[state * _alphabet + _class[(unsigned char) line[i]]];
+        int out = (_terminal[state] != NO_STATE) ? state : _dictLink[state];
+        for (; out != NO_STATE; out = _dictLink[out])
+        {
+            int phrase = _terminal[out];
+            matches.emplace_back(phrase, i + 1 - (int) _phrases[phrase].size());
+        }
+    }
+    return matches.empty() ? 0 : _resolve(matches, length);
+}
+
+/**
+ * Creates a new HashingMatcher for the given database.
+ *
+ * @param database A HashMap that maps from phrases to scores.
+ */
+inline HashingMatcher::HashingMatcher(const HashMap<std::string, int> &database) : PhraseMatcher(database)
+{
+    int count = _phrases.size();
+    for (int i = 0; i < count; i++)
+    {
+        const std::string &phrase = _phrases[i];
+        int length = phrase.size();
+        auto found = std::find(_lengths.begin(), _lengths.end(), length);
+        int table = found - _lengths.begin();
+        if (found == _lengths.end())
+        {
+            unsigned long long power = 1;
+            for (int j = 1; j < length; j++)
+            {
+                power *= ROLLING_BASE;
+            }
+            _lengths.push_back(length);
+            _powers.push_back(power);
+            _tables.emplace_back();
+        }
+
+        unsigned long long hash = 0;
+        for (char ch : phrase)
+        {
+            hash = hash * ROLLING_BASE + (unsigned char) ch;
+        }
+        _tables[table][_mix(hash)].push_back(i);
+    }
+}
+
+/**
+ * Returns the score of the given (lowercase) line.
+ *
+ * @param line The line to score.
+ * @return The sum of the scores of all phrases found in the line.
+ */
+inline int HashingMatcher::score(const std::string &line) const
+{
+    std::vector<std::pair<int, int>> matches;
+    int length = line.size(), tables = _lengths.size();
+    for (int t = 0; t < tables; t++)
+    {
+        int window = _lengths[t];
+        if (window > length)
+        {
+            continue;
+        }
+
+        const HashMap<unsigned long long, std::vector<int>> &table = _tables[t];
+        unsigned long long hash = 0;
+        for (int i = 0; i < length; i++)
+        {
+            if (i >= window)
+            {
+                hash -= (unsigned char) line[i - window] * _powers[t];
+            }
+            hash = hash * ROLLING_BASE + (unsigned char) line[i];
+            if (i + 1 < window)
+            {
+                continue;
+            }
+
+            unsigned long long key = _mix(hash);
+            if (table.containsKey(key))
+            {
+                int start = i + 1 - window;
+                for (int phrase : table.at(key))
+                {
+                    if (line.compare(start, window, _phrases[phrase]) == 0)
+                    {
+                        matches.emplace_back(phrase, start);
+                    }
+                }
+            }
+        }
+    }
+    return matches.empty() ? 0 : _resolve(matches, length);
+}
+
+/**
+ * Creates the engine that best suits the shape of the given database.
+ * A few phrases are searched one by one. Otherwise an automaton is used as long as its table
+ * (about total phrase length times alphabet size) stays small. Past that, rolling hashing is used
+ * if the phrases have at most HASHING_MAX_LENGTHS distinct lengths, since it passes over a line
+ * once per distinct length; with more lengths, the large automaton still scans faster.
+ *
+ * @param database A HashMap that maps from phrases to scores.
+ * @return A new Matcher for the given database.
+ */
+inline std::unique_ptr<Matcher> selectMatcher(const HashMap<std::string, int> &database)
+{
+    if (database.size() <= SUBSTRING_MAX_PHRASES)
+    {
+        return std::unique_ptr<Matcher>(new SubstringMatcher(database));
+    }
+
+    std::vector<bool> alphabet(ALPHABET_SIZE, false);
+    std::vector<size_t> lengths;
+    long long totalLength = 0;
+    for (const std::pair<std::string, int> &pair : database)
+    {
+        for (char ch : pair.first)
+        {
+            alphabet[(unsigned char) ch] = true;
+        }
+        totalLength += pair.first.size();
+        if (std::find(lengths.begin(), lengths.end(), pair.first.size()) == lengths.end() &&
+            lengths.size() <= HASHING_MAX_LENGTHS)
+        {
+            lengths.push_back(pair.first.size());
+        }
+    }
+
+    // The trie has at most one state per phrase character, plus a class for unknown characters.
+    long long classes = std::count(alphabet.begin(), alphabet.end(), true) + 1;
+    if ((totalLength + 1) * classes * (long long) sizeof(int) <= AUTOMATON_MAX_TABLE_BYTES ||
+        lengths.size() > HASHING_MAX_LENGTHS)
+    {
+        return std::unique_ptr<Matcher>(new AutomatonMatcher(database));
+    }
+    return std::unique_ptr<Matcher>(new HashingMatcher(database));
+}
+
+#endif //SPAMDETECTOR_MATCHER_HPP
@@ -0,0 +1,218 @@
+/**
+ * @file MemoryBenchmark.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Benchmark of the real memory cost per entry of every map layout.
+ *
+ * @section DESCRIPTION
+ * This file fills each map layout with generated keys and values and reports, per entry, the
+ * number of live allocations, the bytes requested from operator new while filling (churn,
+ * including buffers freed by growth), the bytes the allocator actually holds at the end
+ * (including chunk headers and rounding) and at the peak of filling (when growth holds the old
+ * and new buffers at once), and the growth of the resident set size. It also
+ * compares a HashMap of URL-like keys with a FrontCodedHashMap of the same keys, and an
+ * IntHashMap of narrow values with a PackedIntHashMap of the same pairs.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <malloc.h>
+#include "AllocCounter.hpp"
+#include "BenchUtils.hpp"
+#include "BenchReport.hpp"
+#include "HashMap.hpp"
+#include "FrontCodedHashMap.hpp"
+#include "PackedIntHashMap.hpp"
+
+#define USAGE_MSG "Usage: MemoryBenchmark [entries] [--json <path>]"
+#define BENCHMARK_NAME "MemoryBenchmark"
+#define DEFAULT_ENTRIES 200000
+#define ENTRIES_INDEX 1
+#define STRING_VALUE_LENGTH 32
+#define NAME_WIDTH 16
+#define TYPE_WIDTH 12
+#define NUMBER_WIDTH 12
+#define URL_SITES 1000
+#define URL_SECTIONS 8
+#define URL_NAME "url"
+#define PACKED_BITS 12
+
+const char *const URL_SECTION_NAMES[URL_SECTIONS] = {"news", "sports", "business", "opinion", "technology",
+                                                     "science", "travel", "style"};
+
+/*
+ * Builds a map with the given function (which returns it, allocated with new), and prints and
+ * reports its cost per entry, from the allocations made while building it (at the end and at the
+ * peak) and the growth of the resident set size.
+ */
+template<typename Build>
+static void measureCost(BenchReport &report, const std::string &layout, const std::string &key,
+                        const std::string &value, int count, Build build)
+{
+    malloc_trim(0);
+    long long rssBefore = residentBytes();
+    AllocStats before = AllocCounter::snapshot();
+    AllocCounter::resetPeak();
+
+    auto *map = build();
+
+    AllocStats used = AllocCounter::snapshot() - before;
+    long long peak = AllocCounter::peakReserved() - before.reservedBytes;
+    long long rss = residentBytes() - rssBefore;
+    delete map;
+
+    double perEntry = 1.0 / count;
+    std::string name = layout + "/" + key + "/" + value + "/";
+    report.add(name + "allocs", "allocations/entry", true, (used.allocations - used.frees) * perEntry);
+    report.add(name + "reserved", "bytes/entry", true, used.reservedBytes * perEntry);
+    report.add(name + "peak", "bytes/entry", true, peak * perEntry);
+    report.add(name + "rss", "bytes/entry", true, rss * perEntry);
+    std::cout << std::left << std::setw(NAME_WIDTH) << layout << std::setw(TYPE_WIDTH) << key
+              << std::setw(TYPE_WIDTH) << value << std::right << std::fixed << std::setprecision(2)
+              << std::setw(NUMBER_WIDTH) << (used.allocations - used.frees) * perEntry
+              << std::setw(NUMBER_WIDTH) << used.requestedBytes * perEntry
+              << std::setw(NUMBER_WIDTH) << used.reservedBytes * perEntry
+              << std::setw(NUMBER_WIDTH) << peak * perEntry
+              << std::setw(NUMBER_WIDTH) << rss * perEntry << std::endl;
+}
+
+/*
+ * Fills a new map of the given layout with the given keys and values and prints its cost per entry.
+ */
+template<typename Layout, typename KeyT, typename ValueT>
+static void measure(BenchReport &report, const std::vector<KeyT> &keys, const std::vector<ValueT> &values,
+                    int keyLength, int valueLength)
+{
+    typedef typename Layout::template Map<KeyT, ValueT> Map;
+    int count = keys.size();
+    measureCost(report, Layout::name(), BenchData<KeyT>::name(keyLength), BenchData<ValueT>::name(valueLength),
+                count, [&]()
+    {
+        Map *map = new Map();
+        for (int i = 0; i < count; i++)
+        {
+            Layout::insert(*map, keys[i], values[i]);
+        }
+        return map;
+    });
+}
+
+// Returns count distinct URL-like keys, which share long prefixes (site, section and date).
+static std::vector<std::string> makeUrls(int count)
+{
+    std::vector<std::string> urls;
+    for (int i = 0; i < count; i++)
+    {
+        unsigned long long random = benchMix(i);
+        urls.push_back("https://www.site" + std::to_string(random % URL_SITES) + ".com/" +
+                       URL_SECTION_NAMES[(random >> 16) % URL_SECTIONS] + "/" +
+                       std::to_string(2000 + (random >> 24) % 25) + "/article-" + std::to_string(i) + ".html");
+    }
+    return urls;
+}
+
+// Measures a HashMap against a FrontCodedHashMap of the same URL-like keys.
+static void measureUrls(BenchReport &report, int count)
+{
+    std::vector<std::string> urls = makeUrls(count);
+    std::vector<int> values = benchItems<int>(count, 0);
+    measureCost(report, ChainedLayout::name(), URL_NAME, BenchData<int>::name(0), count, [&]()
+    {
+        auto *map = new HashMap<std::string, int>();
+        for (int i = 0; i < count; i++)
+        {
+            map->insert(urls[i], values[i]);
+        }
+        return map;
+    });
+    measureCost(report, "FrontCoded", URL_NAME, BenchData<int>::name(0), count, [&]()
+    {
+        return new FrontCodedHashMap<int>(urls, values);
+    });
+}
+
+// Measures an IntHashMap against a PackedIntHashMap of the same keys, with values of PACKED_BITS bits.
+static void measurePacked(BenchReport &report, int count)
+{
+    std::vector<int> keys = benchItems<int>(count, 0);
+    std::string valueName = "uint" + std::to_string(PACKED_BITS);
+    measureCost(report, IntLayout::name(), BenchData<int>::name(0), valueName, count, [&]()
+    {
+        auto *map = new IntHashMap<int, unsigned int>();
+        for (int i = 0; i < count; i++)
+        {
+            map->insert(keys[i], benchMix(i) % (1 << PACKED_BITS));
+        }
+        return map;
+    });
+    measureCost(report, "PackedInt", BenchData<int>::name(0), valueName, count, [&]()
+    {
+        auto *packed = new PackedIntHashMap<int, PACKED_BITS>();
+        for (int i = 0; i < count; i++)
+        {
+            packed->insert(keys[i], benchMix(i) % (1 << PACKED_BITS));
+        }
+        return packed;
+    });
+}
+
+// Measures nothing: the flat layout only takes integer keys.
+template<typename KeyT, typename ValueT>
+static void measureFlat(BenchReport &, const std::vector<KeyT> &, const std::vector<ValueT> &, int, int,
+                        std::false_type)
+{}
+
+// Measures the flat layout of integer keys.
+template<typename KeyT, typename ValueT>
+static void measureFlat(BenchReport &report, const std::vector<KeyT> &keys, const std::vector<ValueT> &values,
+                        int keyLength, int valueLength, std::true_type)
+{
+    measure<IntLayout>(report, keys, values, keyLength, valueLength);
+}
+
+// Measures every layout with the given key and value types.
+template<typename KeyT, typename ValueT>
+static void measureAll(BenchReport &report, int count, int keyLength, int valueLength)
+{
+    std::vector<KeyT> keys = benchItems<KeyT>(count, keyLength);
+    std::vector<ValueT> values = benchItems<ValueT>(count, valueLength);
+    measure<ChainedLayout>(report, keys, values, keyLength, valueLength);
+    measure<StdLayout>(report, keys, values, keyLength, valueLength);
+    measureFlat(report, keys, values, keyLength, valueLength, std::is_integral<KeyT>());
+}
+
+/**
+ * Program's main that receives an optional entry count and prints a table of the memory cost
+ * per entry of every layout, for several key and value types.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    BenchReport report(BENCHMARK_NAME, argc, argv);
+    int count = (argc > ENTRIES_INDEX) ? std::atoi(argv[ENTRIES_INDEX]) : DEFAULT_ENTRIES;
+    if (argc > ENTRIES_INDEX + 1 || count <= 0)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::left << std::setw(NAME_WIDTH) << "layout" << std::setw(TYPE_WIDTH) << "key"
+              << std::setw(TYPE_WIDTH) << "value" << std::right << std::setw(NUMBER_WIDTH) << "allocs"
+              << std::setw(NUMBER_WIDTH) << "churn" << std::setw(NUMBER_WIDTH) << "reserved"
+              << std::setw(NUMBER_WIDTH) << "peak" << std::setw(NUMBER_WIDTH) << "rss" << std::endl;
+
+    measureAll<int, int>(report, count, 0, 0);
+    measureAll<long long, long long>(report, count, 0, 0);
+    measureAll<std::string, int>(report, count, 8, 0);
+    measureAll<std::string, int>(report, count, 24, 0);
+    measureAll<std::string, int>(report, count, 64, 0);
+    measureAll<std::string, std::string>(report, count, 16, STRING_VALUE_LENGTH);
+    measureUrls(report, count);
+    measurePacked(report, count);
+    return report.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
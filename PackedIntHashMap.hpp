@@ -0,0 +1,409 @@
+/**
+ * @file PackedIntHashMap.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Flat map from integer keys to narrow unsigned values, stored bit-packed.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for a map from integers to values of a declared width
+ * in bits, for large tables of small scores and counters. The keys are kept as in IntHashMap, in a
+ * flat table with a sentinel key marking empty slots (and one extra slot for the sentinel key
+ * itself), but without their values beside them: the values live in a separate BitPackedArray,
+ * the value of a slot at the slot's index, so a table of 32-bit keys and 12-bit values takes
+ * 5.5 bytes per slot instead of 8. Values are read and written through Reference proxies, which
+ * refuse values wider than the map's width instead of truncating them.
+ */
+
+#ifndef SPAMDETECTOR_PACKEDINTHASHMAP_HPP
+#define SPAMDETECTOR_PACKEDINTHASHMAP_HPP
+
+#include "IntHashMap.hpp"
+
+#define WORD_BITS 64
+#define ERROR_VALUE_TOO_WIDE "ERROR: Value is wider than the bits of the map's values."
+
+/**
+ * Exception for storing a value that doesn't fit in the width of packed values.
+ */
+class ValueTooWideException : public HashMapException
+{
+public:
+    const char *what() const noexcept override
+    {
+        return ERROR_VALUE_TOO_WIDE;
+    }
+};
+
+/**
+ * Fixed-size array of unsigned values of Bits bits each, packed back to back in 64-bit words (a
+ * value may span two words).
+ *
+ * @tparam Bits The width of every value, from 1 to 32.
+ */
+template<int Bits>
+class BitPackedArray
+{
+    static_assert(Bits >= 1 && Bits <= 32, "Packed values are 1 to 32 bits wide.");
+
+    // The words, with one spare word at the end, so the last value can be read as two words.
+    std::vector<unsigned long long> _words;
+    size_t _size;
+
+public:
+    /**
+     * The largest value that fits.
+     */
+    static const unsigned long long MAX_VALUE = (1ULL << Bits) - 1;
+
+    /**
+     * Proxy for a value in a BitPackedArray, that reads and writes it in place.
+     */
+    class Reference
+    {
+        BitPackedArray &_array;
+        size_t _index;
+
+    public:
+        /**
+         * Creates a proxy for a value.
+         *
+         * @param array The array of the value.
+         * @param index The index of the value.
+         */
+        Reference(BitPackedArray &array, size_t index) noexcept : _array(array), _index(index)
+        {}
+
+        /**
+         * Returns the value.
+         *
+         * @return The value.
+         */
+        operator unsigned int() const noexcept
+        {
+            return _array.get(_index);
+        }
+
+        /**
+         * Writes the value.
+         *
+         * @param value The new value.
+         * @throws ValueTooWideException if the value doesn't fit in Bits bits.
+         * @return This proxy.
+         */
+        Reference &operator=(unsigned int value)
+        {
+            _array.set(_index, value);
+            return *this;
+        }
+
+        /**
+         * Writes the value of another proxy.
+         *
+         * @param other The proxy of the value to copy.
+         * @return This proxy.
+         */
+        Reference &operator=(const Reference &other) noexcept
+        {
+            _array.set(_index, other);
+            return *this;
+        }
+
+        /**
+         * Adds to the value.
+         *
+         * @param value The value to add.
+         * @throws ValueTooWideException if the sum doesn't fit in Bits bits.
+         * @return This proxy.
+         */
+        Reference &operator+=(unsigned int value)
+        {
+            _array.set(_index, (unsigned long long) _array.get(_index) + value);
+            return *this;
+        }
+    };
+
+    /**
+     * Creates an array of zeros.
+     *
+     * @param size How many values there are.
+     */
+    explicit BitPackedArray(size_t size) : _words((size * Bits + WORD_BITS - 1) / WORD_BITS + 1, 0), _size(size)
+    {}
+
+    /**
+     * Returns how many values there are.
+     *
+     * @return How many values there are.
+     */
+    size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    /**
+     * Returns a value.
+     *
+     * @param index The index of the value.
+     * @return The value.
+     */
+    unsigned int get(size_t index) const noexcept
+    {
+        size_t bit = index * Bits, word = bit / WORD_BITS, shift = bit % WORD_BITS;
+        // The high part comes from the next word; shifting in two steps keeps it 0 if shift is 0.
+        unsigned long long low = _words[word] >> shift, high = (_words[word + 1] << 1) << (WORD_BITS - 1 - shift);
+        return (unsigned int) ((low | high) & MAX_VALUE);
+    }
+
+    /**
+     * Writes a value.
+     *
+     * @param index The index of the value.
+     * @param value The new value.
+     * @throws ValueTooWideException if the value doesn't fit in Bits bits.
+     */
+    void set(size_t index, unsigned long long value)
+    {
+        if (value > MAX_VALUE)
+        {
+            throw ValueTooWideException();
+        }
+        size_t bit = index * Bits, word = bit / WORD_BITS, shift = bit % WORD_BITS;
+        _words[word] = (_words[word] & ~(MAX_VALUE << shift)) | (value << shift);
+        // The bits past the word (none if the value ends in it) go to the low bits of the next word.
+        unsigned long long spill = (MAX_VALUE >> 1) >> (WORD_BITS - 1 - shift);
+        _words[word + 1] = (_words[word + 1] & ~spill) | ((value >> 1) >> (WORD_BITS - 1 - shift));
+    }
+
+    /**
+     * Returns a proxy for a value.
+     *
+     * @param index The index of the value.
+     * @return A proxy for the value.
+     */
+    Reference operator[](size_t index) noexcept
+    {
+        return Reference(*this, index);
+    }
+
+    /**
+     * Sets all values to 0.
+     */
+    void clear() noexcept
+    {
+        std::fill(_words.begin(), _words.end(), 0);
+    }
+
+    /**
+     * Returns how many bytes this array holds on the heap.
+     *
+     * @return How many bytes this array holds on the heap.
+     */
+    size_t heapBytes() const noexcept
+    {
+        return _words.capacity() * sizeof(unsigned long long);
+    }
+};
+
+/**
+ * Slots of a PackedIntHashMap: the keys in one array, and their values bit-packed in another at the
+ * same indices (see IntSlotTable).
+ *
+ * @tparam KeyT The key type.
+ * @tparam Bits The width of every value, from 1 to 32.
+ */
+template<typename KeyT, int Bits>
+class PackedSlots
+{
+    std::vector<KeyT> _keys;
+    BitPackedArray<Bits> _values;
+
+public:
+    typedef std::pair<KeyT, unsigned int> Reference;
+
+    // Points at a pair that is built from its slot, since packed pairs aren't stored as pairs.
+    struct Pointer
+    {
+        std::pair<KeyT, unsigned int> pair;
+
+        const std::pair<KeyT, unsigned int> *operator->() const noexcept
+        {
+            return &pair;
+        }
+    };
+
+    // Creates count slots holding the given key and a default value.
+    PackedSlots(size_t count, KeyT empty) : _keys(count, empty), _values(count)
+    {}
+
+    // Returns the key of a slot.
+    KeyT key(size_t i) const noexcept
+    {
+        return _keys[i];
+    }
+
+    // Sets the key of a slot.
+    void setKey(size_t i, KeyT key) noexcept
+    {
+        _keys[i] = key;
+    }
+
+    // Moves the key and value of a slot to another.
+    void move(size_t from, size_t to)
+    {
+        _keys[to] = _keys[from];
+        _values.set(to, _values.get(from));
+    }
+
+    // Moves the key and value of a slot of another table to a slot of this one.
+    void moveFrom(PackedSlots &other, size_t from, size_t to)
+    {
+        _keys[to] = other._keys[from];
+        _values.set(to, other._values.get(from));
+    }
+
+    // Resets the value of a slot.
+    void clearValue(size_t i)
+    {
+        _values.set(i, 0);
+    }
+
+    // Sets every slot to the given key and a default value.
+    void clear(KeyT empty) noexcept
+    {
+        std::fill(_keys.begin(), _keys.end(), empty);
+        _values.clear();
+    }
+
+    // Returns a proxy for the value of a slot.
+    typename BitPackedArray<Bits>::Reference value(size_t i) noexcept
+    {
+        return _values[i];
+    }
+
+    // Returns the value of a slot. (Const version)
+    unsigned int value(size_t i) const noexcept
+    {
+        return _values.get(i);
+    }
+
+    // Returns the pair of a slot.
+    Reference pair(size_t i) const noexcept
+    {
+        return Reference(_keys[i], _values.get(i));
+    }
+
+    // Returns a pointer to the pair of a slot.
+    Pointer pointer(size_t i) const noexcept
+    {
+        return Pointer{pair(i)};
+    }
+
+    // Swaps the slots with those of another table.
+    void swap(PackedSlots &other) noexcept
+    {
+        _keys.swap(other._keys);
+        std::swap(_values, other._values);
+    }
+
+    // Returns how many bytes the slots hold on the heap.
+    size_t heapBytes() const noexcept
+    {
+        return _keys.capacity() * sizeof(KeyT) + _values.heapBytes();
+    }
+};
+
+/**
+ * Map from integer keys to unsigned values of Bits bits, with the values bit-packed. Its iterators
+ * yield the pairs by value.
+ *
+ * @tparam KeyT The key type (an integral type).
+ * @tparam Bits The width of every value, from 1 to 32.
+ */
+template<typename KeyT, int Bits>
+class PackedIntHashMap : public IntSlotTable<KeyT, PackedSlots<KeyT, Bits>>
+{
+public:
+    typedef typename BitPackedArray<Bits>::Reference Reference;
+
+    /**
+     * Creates an empty map.
+     */
+    PackedIntHashMap() = default;
+
+    /**
+     * Returns true if insertion to this map is successful. Otherwise returns false.
+     * Failure to insert happens when key already exists in this map.
+     *
+     * @param key The key to insert.
+     * @param value The value to insert.
+     * @throws ValueTooWideException if the value doesn't fit in Bits bits (and then nothing is inserted).
+     * @return True if insertion to this map is successful. Otherwise returns false.
+     */
+    bool insert(KeyT key, unsigned int value)
+    {
+        if (value > BitPackedArray<Bits>::MAX_VALUE)
+        {
+            throw ValueTooWideException();
+        }
+        bool added;
+        size_t i = this->_findOrAdd(key, added);
+        if (added)
+        {
+            this->_slots.value(i) = value;
+        }
+        return added;
+    }
+
+    /**
+     * Returns the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception. (Const version)
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return The value paired with the given key.
+     */
+    unsigned int at(KeyT key) const
+    {
+        long long i = this->_find(key);
+        if (i < 0)
+        {
+            throw KeyNotFoundException();
+        }
+        return this->_slots.value(i);
+    }
+
+    /**
+     * Returns a proxy for the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception.
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return A proxy for the value paired with the given key.
+     */
+    Reference at(KeyT key)
+    {
+        long long i = this->_find(key);
+        if (i < 0)
+        {
+            throw KeyNotFoundException();
+        }
+        return this->_slots.value(i);
+    }
+
+    /**
+     * Returns a proxy for the value paired with the given key, pairing it with 0 first if it
+     * isn't in this map. The proxy is valid until the next insertion or erasure.
+     *
+     * @param key The key to find.
+     * @return A proxy for the value paired with the given key.
+     */
+    Reference operator[](KeyT key)
+    {
+        bool added;
+        return this->_slots.value(this->_findOrAdd(key, added));
+    }
+};
+
+#endif //SPAMDETECTOR_PACKEDINTHASHMAP_HPP
@@ -0,0 +1,207 @@
+/**
+ * @file PerfCounters.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Hardware performance counters for the benchmarks, through perf_event_open.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for a small set of hardware counters (instructions,
+ * cache misses, data TLB misses and branch mispredictions) measured around a benchmark section.
+ * Counters that the kernel, the CPU or the container don't allow are simply reported as missing.
+ */
+
+#ifndef SPAMDETECTOR_PERFCOUNTERS_HPP
+#define SPAMDETECTOR_PERFCOUNTERS_HPP
+
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define PERF_COUNTERS 4
+#define NO_COUNTER -1
+#define PERF_MISSING "-"
+
+/**
+ * Values of the counters over a measured section.
+ */
+struct PerfSample
+{
+    long long values[PERF_COUNTERS];
+    bool valid[PERF_COUNTERS];
+
+    /**
+     * Returns the value of every counter divided by the given number of operations, as
+     * space-separated fields, with "-" for counters that aren't available.
+     *
+     * @param operations The number of operations in the measured section.
+     * @param width The width of every field.
+     * @return The per-operation counters as text.
+     */
+    std::string perOperation(long long operations, int width) const
+    {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        for (int i = 0; i < PERF_COUNTERS; i++)
+        {
+            out << std::setw(width);
+            if (valid[i] && operations > 0)
+            {
+                out << (double) values[i] / operations;
+            }
+            else
+            {
+                out << PERF_MISSING;
+            }
+        }
+        return out.str();
+    }
+};
+
+/**
+ * Set of hardware counters of the calling process (including threads it creates later).
+ * Construction opens whatever counters are available; when none are, start and stop do nothing.
+ */
+class PerfCounters
+{
+    int _fds[PERF_COUNTERS];
+
+    PerfCounters(const PerfCounters &) = delete;
+
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+#if defined(__linux__)
+    // Opens a single counter of this process, or returns NO_COUNTER.
+    static int _open(unsigned int type, unsigned long long config) noexcept
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        return (fd < 0) ? NO_COUNTER : (int) fd;
+    }
+#endif
+
+public:
+    /**
+     * Returns the names of the counters, as space-separated fields.
+     *
+     * @param width The width of every field.
+     * @return The names of the counters.
+     */
+    static std::string names(int width)
+    {
+        std::ostringstream out;
+        for (const char *name : {"instr/op", "cmiss/op", "tlbmiss/op", "brmiss/op"})
+        {
+            out << std::setw(width) << name;
+        }
+        return out.str();
+    }
+
+    /**
+     * Opens the counters that are available.
+     */
+    PerfCounters() noexcept
+    {
+#if defined(__linux__)
+        _fds[0] = _open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        _fds[1] = _open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        _fds[2] = _open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        _fds[3] = _open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#else
+        std::fill(_fds, _fds + PERF_COUNTERS, NO_COUNTER);
+#endif
+    }
+
+    /**
+     * Closes the counters.
+     */
+    ~PerfCounters() noexcept
+    {
+        for (int fd : _fds)
+        {
+            if (fd != NO_COUNTER)
+            {
+                close(fd);
+            }
+        }
+    }
+
+    /**
+     * Returns true if at least one counter is available. Otherwise, returns false.
+     *
+     * @return True if at least one counter is available.
+     */
+    bool available() const noexcept
+    {
+        for (int fd : _fds)
+        {
+            if (fd != NO_COUNTER)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Resets and starts the counters.
+     */
+    void start() noexcept
+    {
+#if defined(__linux__)
+        for (int fd : _fds)
+        {
+            if (fd != NO_COUNTER)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    /**
+     * Stops the counters and returns their values since start.
+     *
+     * @return The values of the counters since start.
+     */
+    PerfSample stop() noexcept
+    {
+        PerfSample sample;
+        for (int i = 0; i < PERF_COUNTERS; i++)
+        {
+            sample.values[i] = 0;
+            sample.valid[i] = false;
+#if defined(__linux__)
+            if (_fds[i] != NO_COUNTER)
+            {
+                ioctl(_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+                long long value;
+                sample.valid[i] = read(_fds[i], &value, sizeof(value)) == sizeof(value);
+                sample.values[i] = sample.valid[i] ? value : 0;
+            }
+#endif
+        }
+        return sample;
+    }
+};
+
+#endif //SPAMDETECTOR_PERFCOUNTERS_HPP
@@ -0,0 +1,210 @@
+/**
+ * @file PersistentBenchmark.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Benchmark of durable writes and recovery of the PersistentHashMap.
+ *
+ * @section DESCRIPTION
+ * This file measures the throughput of durable updates from growing numbers of threads (and how
+ * many updates share a group commit), the throughput of asynchronous updates, and the time to
+ * reopen a map from its snapshot and log compared to rebuilding it from scratch. It first checks
+ * that records written after a torn log tail survive the next recovery.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <fstream>
+#include "BenchUtils.hpp"
+#include "BenchReport.hpp"
+#include "PersistentHashMap.hpp"
+
+#define USAGE_MSG "Usage: PersistentBenchmark [entries] [max threads] [durable updates] [--json <path>]"
+#define BENCHMARK_NAME "PersistentBenchmark"
+#define TEMP_TEMPLATE "/tmp/PersistentBenchmarkXXXXXX"
+#define TORN_DIRECTORY "/torn"
+#define TORN_BYTES "\x20\0\0"
+#define ENTRIES_INDEX 1
+#define THREADS_INDEX 2
+#define UPDATES_INDEX 3
+#define DEFAULT_ENTRIES 1000000
+#define DEFAULT_THREADS 8
+#define DEFAULT_UPDATES 4000
+#define KEY_LENGTH 16
+#define NAME_WIDTH 24
+#define NUMBER_WIDTH 14
+
+// Returns the seconds since the given time.
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Prints and records a line of results.
+static void print(BenchReport &report, const std::string &name, const char *unit, bool lowerIsBetter,
+                  double value, double extra = -1)
+{
+    report.add(name, unit, lowerIsBetter, value);
+    std::cout << std::left << std::setw(NAME_WIDTH) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(NUMBER_WIDTH) << value << " " << unit;
+    if (extra >= 0)
+    {
+        std::cout << std::setw(NUMBER_WIDTH) << extra << " per commit";
+    }
+    std::cout << std::endl;
+}
+
+// Runs durable updates from the given number of threads and prints their throughput.
+static void measureDurable(BenchReport &report, PersistentHashMap<std::string, long long> &map,
+                           const std::vector<std::string> &keys, int threads, int updates)
+{
+    long long commitsBefore = map.commits();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            for (int i = t; i < updates; i += threads)
+            {
+                map.update(keys[benchMix(i) % keys.size()], i);
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = secondsSince(start);
+    long long commits = map.commits() - commitsBefore;
+    print(report, "durable/" + std::to_string(threads) + " threads", "ops/s", false, updates / seconds,
+          commits > 0 ? (double) updates / commits : 0);
+}
+
+// Appends the first bytes of a record to a log segment, as a crash in the middle of a write would.
+static void tearSegment(const std::string &directory, unsigned long long start)
+{
+    char name[SEGMENT_NAME_LENGTH];
+    std::snprintf(name, sizeof(name), SEGMENT_FORMAT, start);
+    std::ofstream(directory + name, std::ios::binary | std::ios::app).write(TORN_BYTES, sizeof(TORN_BYTES) - 1);
+}
+
+// Checks that changes made after recovering from a torn log tail (a whole torn segment, and then
+// the torn end of one) survive the next recovery, and a snapshot. Returns false if any is lost.
+static bool checkTornLog(const std::string &directory)
+{
+    {
+        PersistentHashMap<std::string, long long> map(directory);
+        map.insert("a", 1);
+    }
+    tearSegment(directory, 2); // The first record of the next segment.
+    {
+        PersistentHashMap<std::string, long long> map(directory);
+        map.insert("b", 2);
+        map.insert("c", 3);
+    }
+    tearSegment(directory, 2); // The end of a segment with records.
+    {
+        PersistentHashMap<std::string, long long> map(directory);
+        map.insert("d", 4);
+    }
+    {
+        PersistentHashMap<std::string, long long> map(directory);
+        map.snapshot();
+        map.waitForSnapshot();
+    }
+    PersistentHashMap<std::string, long long> map(directory);
+    bool ok = map.size() == 4;
+    for (const char *key : {"a", "b", "c", "d"})
+    {
+        ok = ok && map.containsKey(key) && map.at(key) == key[0] - 'a' + 1;
+    }
+    if (!ok)
+    {
+        std::cerr << "Changes after a torn log tail were lost in recovery." << std::endl;
+    }
+    return ok;
+}
+
+/**
+ * Program's main that receives an optional entry count, maximum thread count and number of
+ * durable updates, and prints write throughputs and the recovery time against a rebuild.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    BenchReport report(BENCHMARK_NAME, argc, argv);
+    int count = (argc > ENTRIES_INDEX) ? std::atoi(argv[ENTRIES_INDEX]) : DEFAULT_ENTRIES;
+    int maxThreads = (argc > THREADS_INDEX) ? std::atoi(argv[THREADS_INDEX]) : DEFAULT_THREADS;
+    int updates = (argc > UPDATES_INDEX) ? std::atoi(argv[UPDATES_INDEX]) : DEFAULT_UPDATES;
+    char directory[] = TEMP_TEMPLATE;
+    if (argc > UPDATES_INDEX + 1 || count <= 0 || maxThreads <= 0 || updates <= 0 || mkdtemp(directory) == nullptr)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<std::string> keys = benchItems<std::string>(count, KEY_LENGTH);
+
+    auto start = std::chrono::steady_clock::now();
+    HashMap<std::string, long long> rebuilt;
+    for (int i = 0; i < count; i++)
+    {
+        rebuilt.insert(keys[i], i);
+    }
+    print(report, "rebuild", "ms", true, secondsSince(start) * 1000);
+
+    try
+    {
+        if (!checkTornLog(directory + std::string(TORN_DIRECTORY)))
+        {
+            return EXIT_FAILURE;
+        }
+        {
+            PersistentHashMap<std::string, long long> map(directory, false);
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < count; i++)
+            {
+                map.insert(keys[i], i);
+            }
+            map.flush();
+            print(report, "asynchronous inserts", "ops/s", false, count / secondsSince(start));
+            map.snapshot();
+            map.waitForSnapshot();
+        }
+        {
+            PersistentHashMap<std::string, long long> map(directory, true);
+            for (int threads = 1; threads <= maxThreads; threads *= 2)
+            {
+                measureDurable(report, map, keys, threads, updates);
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        PersistentHashMap<std::string, long long> map(directory);
+        print(report, "recovery", "ms", true, secondsSince(start) * 1000);
+        if (map.size() != count)
+        {
+            std::cerr << "Recovered " << map.size() << " of " << count << " entries." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (PersistenceException &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string command = std::string("rm -rf ") + directory;
+    if (std::system(command.c_str()) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+    return report.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,852 @@
+/**
+ * @file PersistentHashMap.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief A crash-recoverable HashMap: an append-only operation log plus background snapshots.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for the PersistentHashMap class. Every change is
+ * applied to an in-memory HashMap and appended to a log that a single thread writes and syncs in
+ * groups, so that concurrent writers share one fdatasync. Snapshots are built in the background
+ * from the previous snapshot and the log they replace, so writers never wait for one, and
+ * recovery loads the latest snapshot and replays the log after it.
+ */
+
+#ifndef SPAMDETECTOR_PERSISTENTHASHMAP_HPP
+#define SPAMDETECTOR_PERSISTENTHASHMAP_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "HashMap.hpp"
+#include "Serializer.hpp"
+
+#define SNAPSHOT_FILE "/snapshot"
+#define SNAPSHOT_TEMP_FILE "/snapshot.tmp"
+#define SEGMENT_PREFIX "log-"
+#define SEGMENT_FORMAT "/log-%020llu"
+#define SEGMENT_NAME_LENGTH 32
+#define SNAPSHOT_MAGIC 0x50484d534e415031ULL
+#define DEFAULT_SNAPSHOT_LOG_BYTES (64LL * 1024 * 1024)
+#define READ_CHUNK 65536
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+#define OP_INSERT 1
+#define OP_UPDATE 2
+#define OP_ERASE 3
+#define OP_CLEAR 4
+#define ERROR_PERSIST_OPEN "ERROR: Can't open the PersistentHashMap directory or its files."
+#define ERROR_PERSIST_CORRUPT "ERROR: The PersistentHashMap snapshot is corrupt."
+#define ERROR_PERSIST_WRITE "ERROR: PersistentHashMap failed to write its log."
+
+/**
+ * Exception for I/O failures and corruption of a PersistentHashMap.
+ */
+class PersistenceException : public HashMapException
+{
+    const char *_message;
+
+public:
+    explicit PersistenceException(const char *message) noexcept : _message(message) {}
+
+    const char *what() const noexcept override
+    {
+        return _message;
+    }
+};
+
+/**
+ * HashMap that survives restarts and crashes.
+ *
+ * Every record of the log carries a sequence number and a checksum. Recovery stops at the first
+ * torn or corrupt record, which can only be the tail of the last write, and cuts it off the log.
+ * The log is split into segments named by their first sequence number. A snapshot covers every record up to its
+ * sequence number, and the segments before it are deleted once it is on disk.
+ *
+ * All methods are thread-safe. In synchronous mode a change returns only once it is durable.
+ * Otherwise it returns at once and flush() waits for everything so far.
+ *
+ * @tparam KeyT The key type (with a Serializer).
+ * @tparam ValueT The value type (with a Serializer).
+ */
+template<typename KeyT, typename ValueT>
+class PersistentHashMap
+{
+    // Returns the FNV-1a checksum of the given bytes.
+    static unsigned long long _checksum(const char *data, size_t size) noexcept
+    {
+        unsigned long long hash = FNV_OFFSET;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ (unsigned char) data[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    // Writes all of the given bytes. Returns false on failure.
+    static bool _writeAll(int fd, const char *data, size_t size) noexcept
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, data, size);
+            if (written <= 0)
+            {
+                return false;
+            }
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    // Reads a whole file into the given string. Returns false if it can't be opened.
+    static bool _readFile(const std::string &path, std::string &content);
+
+    // Returns the path of the log segment that starts at the given sequence number.
+    std::string _segmentPath(unsigned long long start) const
+    {
+        char name[SEGMENT_NAME_LENGTH];
+        std::snprintf(name, sizeof(name), SEGMENT_FORMAT, start);
+        return _directory + name;
+    }
+
+    // Returns the first sequence numbers of the log segments, in order.
+    std::vector<unsigned long long> _segments() const;
+
+    // Syncs the directory, so that created, renamed and deleted files are durable.
+    bool _syncDirectory() const noexcept;
+
+    // Opens (creating if needed) the log segment that starts at the given sequence number.
+    int _openSegment(unsigned long long start) const noexcept;
+
+    // Applies a serialized operation to a map. Returns false if the record is malformed.
+    static bool _apply(HashMap<KeyT, ValueT> &map, const char *in, const char *end);
+
+    // Loads the snapshot file into a map and returns the sequence number it covers (0 if none).
+    unsigned long long _loadSnapshot(HashMap<KeyT, ValueT> &map) const;
+
+    // Replays the records of a segment's content from next through last into a map, advancing next.
+    // Returns the length of the content before its torn tail (if it has one).
+    static size_t _replay(HashMap<KeyT, ValueT> &map, const std::string &content, unsigned long long &next,
+                          unsigned long long last);
+
+    // Loads the snapshot and replays the log after it.
+    void _recover();
+
+    // Appends an operation to the pending log and returns its sequence number (lock held).
+    unsigned long long _append(int op, const KeyT *key, const ValueT *value);
+
+    // Waits until the given sequence number is durable, if synchronous (lock held).
+    void _commit(std::unique_lock<std::mutex> &lock, unsigned long long sequence);
+
+    // Starts a background snapshot unless one is running (lock held).
+    bool _startSnapshot();
+
+    // Writes a snapshot of the records up to the given sequence number and deletes the log
+    // segments it covers.
+    void _writeSnapshot(unsigned long long sequence);
+
+    // The body of the log writer thread.
+    void _flushLoop();
+
+    std::string _directory;
+    bool _synchronous;
+    long long _snapshotLogBytes, _logBytes = 0;
+    HashMap<KeyT, ValueT> _map;
+
+    std::mutex _mutex;
+    std::condition_variable _wake, _durableChanged, _snapshotDone;
+    std::string _pending, _sealed; // Sealed records go to the segment before the next rotation.
+    unsigned long long _nextSequence = 1, _durable = 0, _snapshotSequence = 0, _rotation = 0;
+    long long _commits = 0;
+    bool _failed = false, _stopping = false, _snapshotRunning = false;
+    int _logFd = -1;
+    std::thread _writer, _snapshotter;
+
+public:
+    /**
+     * Opens (creating if needed) the map stored in the given directory and recovers its contents.
+     *
+     * @param directory The directory of the map's files.
+     * @param synchronous If true, every change returns only once it is durable.
+     * @param snapshotLogBytes How many bytes of log trigger a background snapshot (0 for never).
+     * @throws PersistenceException if the directory can't be used or the snapshot is corrupt.
+     */
+    explicit PersistentHashMap(const std::string &directory, bool synchronous = true,
+                               long long snapshotLogBytes = DEFAULT_SNAPSHOT_LOG_BYTES);
+
+    PersistentHashMap(const PersistentHashMap &) = delete;
+
+    PersistentHashMap &operator=(const PersistentHashMap &) = delete;
+
+    /**
+     * Destructor for PersistentHashMap. Writes and syncs all pending changes and waits for a
+     * running snapshot.
+     */
+    ~PersistentHashMap() noexcept;
+
+    /**
+     * Returns how many elements are currently in this map.
+     *
+     * @return How many elements are currently in this map.
+     */
+    int size()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _map.size();
+    }
+
+    /**
+     * Returns true if this map contains the given key. Otherwise, returns false.
+     *
+     * @param key The key to find.
+     * @return True if this map contains the given key. Otherwise, returns false.
+     */
+    bool containsKey(const KeyT &key)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _map.containsKey(key);
+    }
+
+    /**
+     * Returns (a copy of) the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception.
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return The value paired with the given key.
+     */
+    ValueT at(const KeyT &key)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _map.at(key);
+    }
+
+    /**
+     * Returns true if insertion to this map is successful. Otherwise returns false.
+     * Failure to insert happens when key already exists in this map.
+     *
+     * @param key The key to insert.
+     * @param value The value to insert.
+     * @throws PersistenceException if the log can't be written.
+     * @return True if insertion to this map is successful. Otherwise returns false.
+     */
+    bool insert(const KeyT &key, const ValueT &value);
+
+    /**
+     * Returns true if the given key was found in this map and its value replaced.
+     * Otherwise, returns false.
+     *
+     * @param key The key to find.
+     * @param value The new value.
+     * @throws PersistenceException if the log can't be written.
+     * @return True if the given key was found in this map.
+     */
+    bool update(const KeyT &key, const ValueT &value);
+
+    /**
+     * Returns true if given key was found in this map and erases it. Otherwise, returns false.
+     *
+     * @param key The key to erase.
+     * @throws PersistenceException if the log can't be written.
+     * @return True if given key was found in this map and erases it. Otherwise, returns false.
+     */
+    bool erase(const KeyT &key);
+
+    /**
+     * Clears this map from all elements.
+     *
+     * @throws PersistenceException if the log can't be written.
+     */
+    void clear();
+
+    /**
+     * Waits until every change made so far is durable.
+     *
+     * @throws PersistenceException if the log can't be written.
+     */
+    void flush();
+
+    /**
+     * Starts a background snapshot. Returns false if one is already running.
+     *
+     * @return True if a snapshot was started.
+     */
+    bool snapshot()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _startSnapshot();
+    }
+
+    /**
+     * Waits for a running snapshot to finish.
+     */
+    void waitForSnapshot()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _snapshotDone.wait(lock, [this]()
+        { return !_snapshotRunning; });
+    }
+
+    /**
+     * Returns how many group commits (log syncs) were made since opening, to compare with the
+     * number of changes.
+     *
+     * @return How many group commits were made.
+     */
+    long long commits()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _commits;
+    }
+};
+
+// Private helper function that reads a whole file.
+template<typename KeyT, typename ValueT>
+bool PersistentHashMap<KeyT, ValueT>::_readFile(const std::string &path, std::string &content)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    char buffer[READ_CHUNK];
+    ssize_t got;
+    while ((got = ::read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        content.append(buffer, got);
+    }
+    close(fd);
+    return got == 0;
+}
+
+// Private method that lists the log segments by their first sequence number.
+template<typename KeyT, typename ValueT>
+std::vector<unsigned long long> PersistentHashMap<KeyT, ValueT>::_segments() const
+{
+    std::vector<unsigned long long> starts;
+    DIR *dir = opendir(_directory.c_str());
+    if (dir == nullptr)
+    {
+        return starts;
+    }
+    size_t prefix = std::strlen(SEGMENT_PREFIX);
+    for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+    {
+        if (std::strncmp(entry->d_name, SEGMENT_PREFIX, prefix) == 0)
+        {
+            starts.push_back(std::strtoull(entry->d_name + prefix, nullptr, 10));
+        }
+    }
+    closedir(dir);
+    std::sort(starts.begin(), starts.end());
+    return starts;
+}
+
+// Private method that syncs the directory entry changes.
+template<typename KeyT, typename ValueT>
+bool PersistentHashMap<KeyT, ValueT>::_syncDirectory() const noexcept
+{
+    int fd = ::open(_directory.c_str(), O_RDONLY | O_DIRECTORY);
+    bool ok = fd >= 0 && fsync(fd) == 0;
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    return ok;
+}
+
+// Private method that opens a log segment for appending.
+template<typename KeyT, typename ValueT>
+int PersistentHashMap<KeyT, ValueT>::_openSegment(unsigned long long start) const noexcept
+{
+    int fd = ::open(_segmentPath(start).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd >= 0 && !_syncDirectory())
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Private helper function that applies one operation (without its sequence number) to a map.
+template<typename KeyT, typename ValueT>
+bool PersistentHashMap<KeyT, ValueT>::_apply(HashMap<KeyT, ValueT> &map, const char *in, const char *end)
+{
+    unsigned char op;
+    KeyT key;
+    ValueT value;
+    if (!Serializer<unsigned char>::read(in, end, op))
+    {
+        return false;
+    }
+    switch (op)
+    {
+        case OP_INSERT:
+        case OP_UPDATE:
+            if (!Serializer<KeyT>::read(in, end, key) || !Serializer<ValueT>::read(in, end, value))
+            {
+                return false;
+            }
+            if (!map.insert(key, value))
+            {
+                map.at(key) = value;
+            }
+            return true;
+        case OP_ERASE:
+            if (!Serializer<KeyT>::read(in, end, key))
+            {
+                return false;
+            }
+            map.erase(key);
+            return true;
+        case OP_CLEAR:
+            map.clear();
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Private method that loads the snapshot file.
+template<typename KeyT, typename ValueT>
+unsigned long long PersistentHashMap<KeyT, ValueT>::_loadSnapshot(HashMap<KeyT, ValueT> &map) const
+{
+    // Snapshot: magic, sequence, entries as [key][value], and a checksum of all that.
+    std::string content;
+    unsigned long long sequence = 0;
+    if (_readFile(_directory + SNAPSHOT_FILE, content))
+    {
+        if (content.size() < 3 * sizeof(unsigned long long))
+        {
+            throw PersistenceException(ERROR_PERSIST_CORRUPT);
+        }
+        size_t body = content.size() - sizeof(unsigned long long);
+        const char *in = content.data(), *end = in + body, *tail = end;
+        unsigned long long magic, checksum;
+        if (!Serializer<unsigned long long>::read(tail, in + content.size(), checksum) ||
+            checksum != _checksum(in, body) || !Serializer<unsigned long long>::read(in, end, magic) ||
+            magic != SNAPSHOT_MAGIC || !Serializer<unsigned long long>::read(in, end, sequence))
+        {
+            throw PersistenceException(ERROR_PERSIST_CORRUPT);
+        }
+        KeyT key;
+        ValueT value;
+        while (in < end)
+        {
+            if (!Serializer<KeyT>::read(in, end, key) || !Serializer<ValueT>::read(in, end, value))
+            {
+                throw PersistenceException(ERROR_PERSIST_CORRUPT);
+            }
+            map.insert(key, value);
+        }
+    }
+    return sequence;
+}
+
+// Private helper function that replays the records of one log segment.
+template<typename KeyT, typename ValueT>
+size_t PersistentHashMap<KeyT, ValueT>::_replay(HashMap<KeyT, ValueT> &map, const std::string &content,
+                                                unsigned long long &next, unsigned long long last)
+{
+    // Log records: [payload length][checksum][sequence][operation].
+    const char *in = content.data(), *end = in + content.size();
+    while (in < end)
+    {
+        unsigned int length;
+        unsigned long long checksum, sequence;
+        const char *record = in;
+        if (!Serializer<unsigned int>::read(record, end, length) ||
+            !Serializer<unsigned long long>::read(record, end, checksum) || end - record < (long) length ||
+            checksum != _checksum(record, length))
+        {
+            break; // A torn tail: nothing after it was acknowledged.
+        }
+        const char *payload = record + length;
+        if (!Serializer<unsigned long long>::read(record, payload, sequence) || sequence > last)
+        {
+            break;
+        }
+        in = payload;
+        if (sequence < next)
+        {
+            continue;
+        }
+        if (!_apply(map, record, payload))
+        {
+            throw PersistenceException(ERROR_PERSIST_CORRUPT);
+        }
+        next = sequence + 1;
+    }
+    return in - content.data();
+}
+
+// Private method that loads the snapshot, replays the log after it and opens a new segment.
+template<typename KeyT, typename ValueT>
+void PersistentHashMap<KeyT, ValueT>::_recover()
+{
+    _snapshotSequence = _loadSnapshot(_map);
+    _nextSequence = _snapshotSequence + 1;
+    for (unsigned long long start : _segments())
+    {
+        std::string content, path = _segmentPath(start);
+        if (!_readFile(path, content))
+        {
+            throw PersistenceException(ERROR_PERSIST_OPEN);
+        }
+        size_t valid = _replay(_map, content, _nextSequence, ~0ULL);
+        if (valid < content.size())
+        {
+            // Cut the torn tail off, or records appended to this segment later would follow it
+            // and be lost with it on the next recovery.
+            int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+            bool ok = fd >= 0 && ftruncate(fd, valid) == 0 && fsync(fd) == 0;
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            if (!ok)
+            {
+                throw PersistenceException(ERROR_PERSIST_OPEN);
+            }
+        }
+    }
+    _durable = _nextSequence - 1;
+
+    // New records go to the segment that starts at the next sequence number. It only exists
+    // already if the first record written to it was torn, and then it was just emptied.
+    _logFd = _openSegment(_nextSequence);
+    if (_logFd < 0)
+    {
+        throw PersistenceException(ERROR_PERSIST_OPEN);
+    }
+}
+
+// Private method that serializes an operation into the pending log.
+template<typename KeyT, typename ValueT>
+unsigned long long PersistentHashMap<KeyT, ValueT>::_append(int op, const KeyT *key, const ValueT *value)
+{
+    unsigned long long sequence = _nextSequence++;
+    std::string payload;
+    Serializer<unsigned long long>::write(payload, sequence);
+    Serializer<unsigned char>::write(payload, op);
+    if (key != nullptr)
+    {
+        Serializer<KeyT>::write(payload, *key);
+    }
+    if (value != nullptr)
+    {
+        Serializer<ValueT>::write(payload, *value);
+    }
+
+    size_t before = _pending.size();
+    Serializer<unsigned int>::write(_pending, payload.size());
+    Serializer<unsigned long long>::write(_pending, _checksum(payload.data(), payload.size()));
+    _pending += payload;
+    _logBytes += _pending.size() - before;
+    _wake.notify_one();
+    if (_snapshotLogBytes > 0 && _logBytes >= _snapshotLogBytes)
+    {
+        _startSnapshot();
+    }
+    return sequence;
+}
+
+// Private method that waits for a sequence number to become durable.
+template<typename KeyT, typename ValueT>
+void PersistentHashMap<KeyT, ValueT>::_commit(std::unique_lock<std::mutex> &lock, unsigned long long sequence)
+{
+    if (_synchronous)
+    {
+        _durableChanged.wait(lock, [this, sequence]()
+        { return _durable >= sequence || _failed; });
+    }
+    if (_failed)
+    {
+        throw PersistenceException(ERROR_PERSIST_WRITE);
+    }
+}
+
+// Private method that rotates the log and builds a snapshot of the sealed segments in the background.
+template<typename KeyT, typename ValueT>
+bool PersistentHashMap<KeyT, ValueT>::_startSnapshot()
+{
+    if (_snapshotRunning)
+    {
+        return false;
+    }
+    if (_snapshotter.joinable()) // Done with everything but returning.
+    {
+        _snapshotter.join();
+    }
+
+    // Everything logged so far goes into the snapshot; later records go to a new segment.
+    unsigned long long sequence = _nextSequence - 1;
+    _sealed += _pending;
+    _pending.clear();
+    _rotation = sequence + 1;
+    _logBytes = 0;
+    _snapshotRunning = true;
+    _wake.notify_one();
+    _snapshotter = std::thread(&PersistentHashMap::_writeSnapshot, this, sequence);
+    return true;
+}
+
+// Private method that rebuilds the map as of a sequence number from the previous snapshot and the
+// sealed segments (without the lock), writes it as the new snapshot and deletes the segments.
+template<typename KeyT, typename ValueT>
+void PersistentHashMap<KeyT, ValueT>::_writeSnapshot(unsigned long long sequence)
+{
+    bool ok;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _durableChanged.wait(lock, [this, sequence]()
+        { return _durable >= sequence || _failed; });
+        ok = !_failed;
+    }
+
+    std::string content;
+    try
+    {
+        HashMap<KeyT, ValueT> map;
+        unsigned long long next = _loadSnapshot(map) + 1;
+        for (unsigned long long start : _segments())
+        {
+            if (start > sequence || !ok)
+            {
+                break;
+            }
+            std::string segment;
+            ok = _readFile(_segmentPath(start), segment);
+            _replay(map, segment, next, sequence);
+        }
+        ok = ok && next == sequence + 1;
+        Serializer<unsigned long long>::write(content, SNAPSHOT_MAGIC);
+        Serializer<unsigned long long>::write(content, sequence);
+        for (const auto &pair : map)
+        {
+            Serializer<KeyT>::write(content, pair.first);
+            Serializer<ValueT>::write(content, pair.second);
+        }
+        Serializer<unsigned long long>::write(content, _checksum(content.data(), content.size()));
+    }
+    catch (PersistenceException &)
+    {
+        ok = false;
+    }
+
+    // Write aside and rename, so that a crash leaves either the old or the new snapshot.
+    std::string temp = _directory + SNAPSHOT_TEMP_FILE;
+    int fd = ok ? ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR) : -1;
+    ok = ok && fd >= 0 && _writeAll(fd, content.data(), content.size()) && fsync(fd) == 0;
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    ok = ok && std::rename(temp.c_str(), (_directory + SNAPSHOT_FILE).c_str()) == 0 && _syncDirectory();
+    if (ok)
+    {
+        for (unsigned long long start : _segments())
+        {
+            if (start <= sequence)
+            {
+                ::unlink(_segmentPath(start).c_str());
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (ok)
+    {
+        _snapshotSequence = sequence;
+    }
+    _snapshotRunning = false;
+    _snapshotDone.notify_all();
+}
+
+// Private method run by the log writer thread: writes and syncs whatever accumulated, in groups.
+template<typename KeyT, typename ValueT>
+void PersistentHashMap<KeyT, ValueT>::_flushLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        _wake.wait(lock, [this]()
+        { return _stopping || !_pending.empty() || !_sealed.empty() || _rotation != 0; });
+        if (_pending.empty() && _sealed.empty() && _rotation == 0)
+        {
+            break; // Stopping with nothing left.
+        }
+
+        std::string sealed, pending;
+        sealed.swap(_sealed);
+        pending.swap(_pending);
+        unsigned long long rotation = _rotation, sequence = _nextSequence - 1;
+        _rotation = 0;
+        lock.unlock();
+
+        bool ok = sealed.empty() || (_writeAll(_logFd, sealed.data(), sealed.size()) && fdatasync(_logFd) == 0);
+        if (rotation != 0)
+        {
+            close(_logFd);
+            _logFd = _openSegment(rotation);
+        }
+        ok = ok && _logFd >= 0 &&
+             (pending.empty() || (_writeAll(_logFd, pending.data(), pending.size()) && fdatasync(_logFd) == 0));
+
+        lock.lock();
+        _failed = _failed || !ok;
+        _durable = sequence;
+        _commits++;
+        _durableChanged.notify_all();
+    }
+}
+
+/**
+ * Opens (creating if needed) the map stored in the given directory and recovers its contents.
+ *
+ * @param directory The directory of the map's files.
+ * @param synchronous If true, every change returns only once it is durable.
+ * @param snapshotLogBytes How many bytes of log trigger a background snapshot (0 for never).
+ * @throws PersistenceException if the directory can't be used or the snapshot is corrupt.
+ */
+template<typename KeyT, typename ValueT>
+PersistentHashMap<KeyT, ValueT>::PersistentHashMap(const std::string &directory, bool synchronous,
+                                                   long long snapshotLogBytes) :
+        _directory(directory), _synchronous(synchronous), _snapshotLogBytes(snapshotLogBytes)
+{
+    if (mkdir(directory.c_str(), S_IRWXU) != 0 && errno != EEXIST)
+    {
+        throw PersistenceException(ERROR_PERSIST_OPEN);
+    }
+    _recover();
+    _writer = std::thread(&PersistentHashMap::_flushLoop, this);
+}
+
+/**
+ * Destructor for PersistentHashMap. Writes and syncs all pending changes and waits for a
+ * running snapshot.
+ */
+template<typename KeyT, typename ValueT>
+PersistentHashMap<KeyT, ValueT>::~PersistentHashMap() noexcept
+{
+    waitForSnapshot();
+    if (_snapshotter.joinable())
+    {
+        _snapshotter.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        _wake.notify_one();
+    }
+    _writer.join();
+    close(_logFd);
+}
+
+/**
+ * Returns true if insertion to this map is successful. Otherwise returns false.
+ * Failure to insert happens when key already exists in this map.
+ *
+ * @param key The key to insert.
+ * @param value The value to insert.
+ * @throws PersistenceException if the log can't be written.
+ * @return True if insertion to this map is successful. Otherwise returns false.
+ */
+template<typename KeyT, typename ValueT>
+bool PersistentHashMap<KeyT, ValueT>::insert(const KeyT &key, const ValueT &value)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_map.insert(key, value))
+    {
+        return false;
+    }
+    _commit(lock, _append(OP_INSERT, &key, &value));
+    return true;
+}
+
+/**
+ * Returns true if the given key was found in this map and its value replaced.
+ * Otherwise, returns false.
+ *
+ * @param key The key to find.
+ * @param value The new value.
+ * @throws PersistenceException if the log can't be written.
+ * @return True if the given key was found in this map.
+ */
+template<typename KeyT, typename ValueT>
+bool PersistentHashMap<KeyT, ValueT>::update(const KeyT &key, const ValueT &value)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_map.containsKey(key))
+    {
+        return false;
+    }
+    _map.at(key) = value;
+    _commit(lock, _append(OP_UPDATE, &key, &value));
+    return true;
+}
+
+/**
+ * Returns true if given key was found in this map and erases it. Otherwise, returns false.
+ *
+ * @param key The key to erase.
+ * @throws PersistenceException if the log can't be written.
+ * @return True if given key was found in this map and erases it. Otherwise, returns false.
+ */
+template<typename KeyT, typename ValueT>
+bool PersistentHashMap<KeyT, ValueT>::erase(const KeyT &key)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_map.erase(key))
+    {
+        return false;
+    }
+    _commit(lock, _append(OP_ERASE, &key, nullptr));
+    return true;
+}
+
+/**
+ * Clears this map from all elements.
+ *
+ * @throws PersistenceException if the log can't be written.
+ */
+template<typename KeyT, typename ValueT>
+void PersistentHashMap<KeyT, ValueT>::clear()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _map.clear();
+    _commit(lock, _append(OP_CLEAR, nullptr, nullptr));
+}
+
+/**
+ * Waits until every change made so far is durable.
+ *
+ * @throws PersistenceException if the log can't be written.
+ */
+template<typename KeyT, typename ValueT>
+void PersistentHashMap<KeyT, ValueT>::flush()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    unsigned long long sequence = _nextSequence - 1;
+    _durableChanged.wait(lock, [this, sequence]()
+    { return _durable >= sequence || _failed; });
+    if (_failed)
+    {
+        throw PersistenceException(ERROR_PERSIST_WRITE);
+    }
+}
+
+#endif //SPAMDETECTOR_PERSISTENTHASHMAP_HPP
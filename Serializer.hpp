@@ -0,0 +1,81 @@
+/**
+ * @file Serializer.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Binary serialization of keys and values for the maps that write them to files.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for the Serializer templates, which append values to
+ * a byte string and read them back. Trivially copyable types are copied as their bytes, and
+ * strings are written as a length followed by their bytes. Other types get a specialization.
+ */
+
+#ifndef SPAMDETECTOR_SERIALIZER_HPP
+#define SPAMDETECTOR_SERIALIZER_HPP
+
+#include <string>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Writes and reads values of a type as bytes (for logs, snapshots and spill files).
+ * The general version copies the bytes of trivially copyable types.
+ *
+ * @tparam T The type to serialize.
+ */
+template<typename T>
+struct Serializer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Types that aren't trivially copyable need a Serializer.");
+
+    /**
+     * Appends the value to the output.
+     */
+    static void write(std::string &out, const T &value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    /**
+     * Reads a value and advances the input. Returns false if the input is too short.
+     */
+    static bool read(const char *&in, const char *end, T &value)
+    {
+        if (end - in < (long) sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return true;
+    }
+};
+
+/**
+ * Writes and reads strings as a length followed by their bytes.
+ */
+template<>
+struct Serializer<std::string>
+{
+    static void write(std::string &out, const std::string &value)
+    {
+        Serializer<unsigned int>::write(out, value.size());
+        out += value;
+    }
+
+    static bool read(const char *&in, const char *end, std::string &value)
+    {
+        unsigned int length;
+        if (!Serializer<unsigned int>::read(in, end, length) || end - in < (long) length)
+        {
+            return false;
+        }
+        value.assign(in, length);
+        in += length;
+        return true;
+    }
+};
+
+#endif //SPAMDETECTOR_SERIALIZER_HPP
@@ -0,0 +1,197 @@
+/**
+ * @file SharedBenchmark.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief Benchmark of reader processes sharing one SharedHashMap.
+ *
+ * @section DESCRIPTION
+ * This file builds a string-keyed table once in shared memory and forks growing numbers of
+ * reader processes that attach to it by name and look keys up while the writer keeps updating
+ * values. It reports the attach time, the lookup throughput of all readers together, and the
+ * memory the table takes on the host compared to a private HashMap copy per process.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <sys/wait.h>
+#include "BenchUtils.hpp"
+#include "BenchReport.hpp"
+#include "SharedHashMap.hpp"
+
+#define USAGE_MSG "Usage: SharedBenchmark [entries] [max readers] [lookups per reader] [--json <path>]"
+#define BENCHMARK_NAME "SharedBenchmark"
+#define SEGMENT_NAME "/SharedBenchmark"
+#define ENTRIES_INDEX 1
+#define READERS_INDEX 2
+#define LOOKUPS_INDEX 3
+#define DEFAULT_ENTRIES 1000000
+#define DEFAULT_READERS 8
+#define DEFAULT_LOOKUPS 2000000
+#define KEY_LENGTH 24
+#define UPDATE_PAUSE_US 10
+#define MEGABYTE (1024.0 * 1024.0)
+#define NAME_WIDTH 16
+#define NUMBER_WIDTH 14
+
+/**
+ * What a reader process reports back through its pipe.
+ */
+struct ReaderResult
+{
+    double attachMicroseconds, seconds;
+    long long found;
+};
+
+// The body of a reader process: attaches, looks up keys, and writes its result to the pipe.
+static void runReader(int out, const std::vector<std::string> &keys, int lookups, int seed)
+{
+    ReaderResult result{0, 0, 0};
+    auto start = std::chrono::steady_clock::now();
+    SharedHashMap<int> map = SharedHashMap<int>::open(SEGMENT_NAME);
+    auto attached = std::chrono::steady_clock::now();
+    result.attachMicroseconds = std::chrono::duration<double, std::micro>(attached - start).count();
+
+    int value;
+    for (int i = 0; i < lookups; i++)
+    {
+        result.found += map.find(keys[benchMix(i + seed) % keys.size()], value);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - attached).count();
+    if (write(out, &result, sizeof(result)) != sizeof(result))
+    {
+        _exit(EXIT_FAILURE);
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * Forks the given number of readers, updates values until they are done, and prints their
+ * attach time and total throughput. Returns false if a reader failed or missed a key.
+ */
+static bool measureReaders(BenchReport &report, SharedHashMap<int> &map, const std::vector<std::string> &keys,
+                           int readers, int lookups)
+{
+    std::vector<int> pipes;
+    for (int i = 0; i < readers; i++)
+    {
+        int ends[2];
+        if (pipe(ends) != 0)
+        {
+            return false;
+        }
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(ends[0]);
+            runReader(ends[1], keys, lookups, i * lookups);
+        }
+        close(ends[1]);
+        pipes.push_back(ends[0]);
+    }
+
+    // Keep the writer updating at a steady rate, so that readers also pay for retries.
+    int running = readers, updates = 0;
+    bool ok = true;
+    while (running > 0)
+    {
+        map.update(keys[updates % keys.size()], updates);
+        updates++;
+        usleep(UPDATE_PAUSE_US);
+        int status;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid > 0)
+        {
+            running--;
+            ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+        }
+    }
+
+    double attach = 0, throughput = 0;
+    for (int fd : pipes)
+    {
+        ReaderResult result{0, 0, 0};
+        ok = ok && read(fd, &result, sizeof(result)) == sizeof(result) && result.found == lookups;
+        close(fd);
+        attach = std::max(attach, result.attachMicroseconds);
+        throughput += (result.seconds > 0) ? lookups / result.seconds / 1e6 : 0;
+    }
+
+    std::string name = "SharedHashMap/" + std::to_string(readers) + " readers/";
+    report.add(name + "attach", "us", true, attach);
+    report.add(name + "lookups", "Mops/s", false, throughput);
+    std::cout << std::left << std::setw(NAME_WIDTH) << readers << std::right << std::fixed << std::setprecision(1)
+              << std::setw(NUMBER_WIDTH) << attach << std::setw(NUMBER_WIDTH) << std::setprecision(2) << throughput
+              << std::setw(NUMBER_WIDTH) << updates << std::endl;
+    return ok;
+}
+
+/**
+ * Program's main that receives an optional entry count, maximum number of reader processes and
+ * lookups per reader, and prints the memory of the shared table against private copies, and the
+ * attach time and lookup throughput of 1, 2, 4... readers.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    BenchReport report(BENCHMARK_NAME, argc, argv);
+    int count = (argc > ENTRIES_INDEX) ? std::atoi(argv[ENTRIES_INDEX]) : DEFAULT_ENTRIES;
+    int maxReaders = (argc > READERS_INDEX) ? std::atoi(argv[READERS_INDEX]) : DEFAULT_READERS;
+    int lookups = (argc > LOOKUPS_INDEX) ? std::atoi(argv[LOOKUPS_INDEX]) : DEFAULT_LOOKUPS;
+    if (argc > LOOKUPS_INDEX + 1 || count <= 0 || maxReaders <= 0 || lookups <= 0)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> keys = benchItems<std::string>(count, KEY_LENGTH);
+    long long rssBefore = residentBytes();
+    HashMap<std::string, int> *copy = new HashMap<std::string, int>();
+    for (int i = 0; i < count; i++)
+    {
+        copy->insert(keys[i], i);
+    }
+    long long privateBytes = residentBytes() - rssBefore;
+    delete copy;
+
+    bool ok = true;
+    try
+    {
+        SharedHashMap<int> map = SharedHashMap<int>::create(SEGMENT_NAME, count, (unsigned long long) count * KEY_LENGTH);
+        for (int i = 0; i < count; i++)
+        {
+            map.insert(keys[i], i);
+        }
+
+        report.add("SharedHashMap/segment", "MB", true, map.bytes() / MEGABYTE);
+        report.add("HashMap/private copy", "MB", true, privateBytes / MEGABYTE);
+        std::cout << "shared segment: " << std::fixed << std::setprecision(1) << map.bytes() / MEGABYTE
+                  << " MB for all readers, private HashMap: " << privateBytes / MEGABYTE << " MB per process"
+                  << std::endl;
+        std::cout << std::left << std::setw(NAME_WIDTH) << "readers" << std::right << std::setw(NUMBER_WIDTH)
+                  << "attach us" << std::setw(NUMBER_WIDTH) << "Mlookups/s" << std::setw(NUMBER_WIDTH) << "updates"
+                  << std::endl;
+        for (int readers = 1; readers <= maxReaders; readers *= 2)
+        {
+            ok = measureReaders(report, map, keys, readers, lookups) && ok;
+        }
+    }
+    catch (SharedMemoryException &e)
+    {
+        std::cerr << e.what() << std::endl;
+        ok = false;
+    }
+    SharedHashMap<int>::unlink(SEGMENT_NAME);
+
+    if (!ok)
+    {
+        std::cerr << "A reader failed or missed a key." << std::endl;
+        return EXIT_FAILURE;
+    }
+    return report.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,919 @@
+/**
+ * @file SharedHashMap.hpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief A string-keyed HashMap that lives in shared memory and is read by many processes.
+ *
+ * @section DESCRIPTION
+ * This is a header and implementation file for the SharedHashMap class. The whole map (header and
+ * two regions of slot table and key arena) is one shm_open or memfd segment that refers to its own
+ * contents by offsets only, so every process can map it at any address. One writer process creates
+ * and updates it; reader processes open it read-only and attach without copying anything.
+ */
+
+#ifndef SPAMDETECTOR_SHAREDHASHMAP_HPP
+#define SPAMDETECTOR_SHAREDHASHMAP_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "HashMap.hpp"
+
+#define SHARED_MAGIC 0x48534d5348415245ULL
+#define SHARED_ALIGNMENT 64
+#define SHARED_KEY_BYTES 32
+#define SLOT_EMPTY 0
+#define SLOT_FULL 1
+#define SLOT_ERASED 2
+#define SHARED_REGIONS 2
+#define SHARED_READ_SPINS 64
+#define ERROR_SHARED_CREATE "ERROR: Can't create the SharedHashMap segment."
+#define ERROR_SHARED_OPEN "ERROR: Can't open the SharedHashMap segment, or it isn't a valid one."
+#define ERROR_SHARED_READ_ONLY "ERROR: SharedHashMap was opened read-only."
+#define ERROR_SHARED_FULL "ERROR: SharedHashMap is full."
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "SharedHashMap needs lock-free (address-free) atomics.");
+
+/**
+ * Exception for failures of the shared memory segment of a SharedHashMap.
+ */
+class SharedMemoryException : public HashMapException
+{
+    const char *_message;
+
+public:
+    explicit SharedMemoryException(const char *message) noexcept : _message(message) {}
+
+    const char *what() const noexcept override
+    {
+        return _message;
+    }
+};
+
+/**
+ * String-keyed map in a shared memory segment, with open addressing and a fixed capacity.
+ *
+ * Synchronization is process-shared: writers exclude each other with a robust process-shared
+ * mutex, and readers never write to the segment. Every change readers can see is published under
+ * a sequence lock, and a reader retries a lookup that overlapped one (yielding the CPU after a few
+ * tries). So readers can map the segment read-only, and a reader that dies can't block anybody.
+ *
+ * Erased slots and their key bytes are reclaimed by compacting the table when it runs out of
+ * room. The segment has two regions, each a slot table and a key arena, and readers use the one
+ * the header names. Compacting (and clearing) builds the new table in the other region while
+ * readers go on using the current one, and then publishes it by switching the header to it, so
+ * readers only wait for that one store, and a writer that dies while compacting loses nothing.
+ * The region that is not in use is released (its pages are punched out), so it only takes memory
+ * while a compaction fills it.
+ *
+ * @tparam ValueT The value type (has to be trivially copyable, since it is shared as raw bytes).
+ */
+template<typename ValueT>
+class SharedHashMap
+{
+    static_assert(std::is_trivially_copyable<ValueT>::value, "SharedHashMap values are shared as raw bytes.");
+
+    // The start of the segment. Only the writer changes anything but the lock and the sequence.
+    // Offsets of tables and arenas are from the start of a region.
+    struct Header
+    {
+        unsigned long long magic, slots, capacity, firstRegion, regionBytes, arenaOffset, arenaBytes, totalBytes;
+        unsigned long long arenaUsed[SHARED_REGIONS], used[SHARED_REGIONS]; // Used counts full and erased slots.
+        std::atomic<unsigned int> region;
+        std::atomic<long long> size;
+        std::atomic<unsigned long long> sequence;
+        pthread_mutex_t writer;
+    };
+
+    // A slot of the table. The key lives in the arena.
+    struct Slot
+    {
+        std::atomic<unsigned int> state;
+        unsigned int keyLength;
+        unsigned long long hash, keyOffset;
+        ValueT value;
+    };
+
+    // Holds the writer mutex for the lifetime of an update.
+    class _WriterLock
+    {
+        Header *_header;
+
+    public:
+        explicit _WriterLock(Header *header) : _header(header)
+        {
+            if (pthread_mutex_lock(&_header->writer) == EOWNERDEAD)
+            {
+                // A writer died inside an update. A slot is published by its state, after its key
+                // and value, and a compacted region by the switch to it, so the table readers use
+                // is consistent, and the sequence only has to be made even again.
+                pthread_mutex_consistent(&_header->writer);
+                _header->sequence.fetch_or(1, std::memory_order_relaxed);
+                _header->sequence.fetch_add(1, std::memory_order_release);
+            }
+        }
+
+        ~_WriterLock()
+        {
+            pthread_mutex_unlock(&_header->writer);
+        }
+    };
+
+    // Holds the sequence odd while a change readers can see is made, so they retry around it.
+    class _Publish
+    {
+        Header *_header;
+
+    public:
+        explicit _Publish(Header *header) noexcept : _header(header)
+        {
+            _header->sequence.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        ~_Publish()
+        {
+            _header->sequence.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    static unsigned long long _align(unsigned long long bytes) noexcept
+    {
+        return (bytes + SHARED_ALIGNMENT - 1) & ~(unsigned long long) (SHARED_ALIGNMENT - 1);
+    }
+
+    char *_region(unsigned int region) const noexcept
+    {
+        return _base + _header->firstRegion + region * _header->regionBytes;
+    }
+
+    Slot *_slots(unsigned int region) const noexcept
+    {
+        return reinterpret_cast<Slot *>(_region(region));
+    }
+
+    char *_arena(unsigned int region) const noexcept
+    {
+        return _region(region) + _header->arenaOffset;
+    }
+
+    // The region readers use (only the writer changes it, so the writer reads it relaxed).
+    unsigned int _current() const noexcept
+    {
+        return _header->region.load(std::memory_order_relaxed);
+    }
+
+    // Returns the slot holding the key in a region, or nullptr. Safe on a table that changes meanwhile.
+    const Slot *_find(unsigned int region, const std::string &key, unsigned long long hash) const noexcept;
+
+    // Returns the slot holding the key, or the slot to insert it into (the writer's lookup).
+    Slot *_findForInsert(const std::string &key, unsigned long long hash) noexcept;
+
+    // Empties a region that readers don't use, releasing its memory.
+    void _clearRegion(unsigned int region) noexcept;
+
+    // Rebuilds the table without erased slots and erased keys in the other region, and switches to it.
+    void _compact() noexcept;
+
+    // Maps a segment of the given descriptor, checking it if it isn't a new one.
+    void _map(int fd, bool writable, unsigned long long bytes);
+
+    // Initializes a new segment of the given capacity.
+    void _initialize(int capacity, unsigned long long arenaBytes);
+
+    // Unmaps and closes the segment.
+    void _release() noexcept;
+
+    int _fd = -1;
+    bool _writable = false;
+    unsigned long long _bytes = 0;
+    char *_base = nullptr;
+    Header *_header = nullptr;
+
+    SharedHashMap() noexcept = default;
+
+public:
+    /**
+     * Creates a new named segment (replacing a segment of the same name) that can hold the given
+     * number of entries and key bytes, and maps it for writing.
+     *
+     * @param name The name of the segment, starting with '/'.
+     * @param capacity How many entries the map can hold.
+     * @param arenaBytes How many bytes of keys the map can hold (0 for SHARED_KEY_BYTES per entry).
+     * @throws SharedMemoryException if the segment can't be created.
+     * @return The writer of the new map.
+     */
+    static SharedHashMap create(const std::string &name, int capacity, unsigned long long arenaBytes = 0);
+
+    /**
+     * Creates a new anonymous (memfd) segment, which is shared by passing fd() to other processes,
+     * and maps it for writing.
+     *
+     * @param capacity How many entries the map can hold.
+     * @param arenaBytes How many bytes of keys the map can hold (0 for SHARED_KEY_BYTES per entry).
+     * @throws SharedMemoryException if the segment can't be created.
+     * @return The writer of the new map.
+     */
+    static SharedHashMap createAnonymous(int capacity, unsigned long long arenaBytes = 0);
+
+    /**
+     * Opens an existing named segment for reading.
+     *
+     * @param name The name of the segment.
+     * @throws SharedMemoryException if the segment doesn't exist or isn't a SharedHashMap.
+     * @return A reader of the map.
+     */
+    static SharedHashMap open(const std::string &name);
+
+    /**
+     * Opens an existing segment from a descriptor (such as an inherited fd()) for reading.
+     * The descriptor is duplicated, so the caller keeps its own.
+     *
+     * @param fd The descriptor of the segment.
+     * @throws SharedMemoryException if the descriptor isn't a SharedHashMap segment.
+     * @return A reader of the map.
+     */
+    static SharedHashMap open(int fd);
+
+    /**
+     * Removes the name of a segment. Processes that mapped it keep their mapping.
+     *
+     * @param name The name of the segment.
+     * @return True if the name was removed. Otherwise, returns false.
+     */
+    static bool unlink(const std::string &name) noexcept
+    {
+        return shm_unlink(name.c_str()) == 0;
+    }
+
+    /**
+     * Move constructor for SharedHashMap.
+     *
+     * @param other The map to move from, which is left closed.
+     */
+    SharedHashMap(SharedHashMap &&other) noexcept : _fd(other._fd), _writable(other._writable),
+                                                    _bytes(other._bytes), _base(other._base), _header(other._header)
+    {
+        other._fd = -1;
+        other._base = nullptr;
+        other._header = nullptr;
+    }
+
+    /**
+     * Move assignment operator for SharedHashMap.
+     *
+     * @param other The map to move from, which is left closed.
+     * @return Instance of this map after the move.
+     */
+    SharedHashMap &operator=(SharedHashMap &&other) noexcept
+    {
+        if (this != &other)
+        {
+            _release();
+            std::swap(_fd, other._fd);
+            std::swap(_writable, other._writable);
+            std::swap(_bytes, other._bytes);
+            std::swap(_base, other._base);
+            std::swap(_header, other._header);
+        }
+        return *this;
+    }
+
+    SharedHashMap(const SharedHashMap &) = delete;
+
+    SharedHashMap &operator=(const SharedHashMap &) = delete;
+
+    /**
+     * Destructor for SharedHashMap. Unmaps the segment, which stays alive while it has a name or
+     * other processes map it.
+     */
+    ~SharedHashMap() noexcept
+    {
+        _release();
+    }
+
+    /**
+     * Returns how many elements are currently in this map.
+     *
+     * @return How many elements are currently in this map.
+     */
+    int size() const noexcept
+    {
+        return (int) _header->size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns how many elements this map can hold.
+     *
+     * @return How many elements this map can hold.
+     */
+    int capacity() const noexcept
+    {
+        return (int) _header->capacity;
+    }
+
+    /**
+     * Returns true if there no elements in this map. Otherwise, returns false.
+     *
+     * @return True if there no elements in this map. Otherwise, returns false.
+     */
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /**
+     * Returns the size of the whole segment in bytes.
+     *
+     * @return The size of the whole segment in bytes.
+     */
+    unsigned long long bytes() const noexcept
+    {
+        return _header->totalBytes;
+    }
+
+    /**
+     * Returns the descriptor of the segment, to pass to other processes.
+     *
+     * @return The descriptor of the segment.
+     */
+    int fd() const noexcept
+    {
+        return _fd;
+    }
+
+    /**
+     * Returns true if this map was opened read-only. Otherwise, returns false.
+     *
+     * @return True if this map was opened read-only.
+     */
+    bool readOnly() const noexcept
+    {
+        return !_writable;
+    }
+
+    /**
+     * Returns true and copies the value paired with the given key, if it is in this map.
+     * Otherwise, returns false.
+     *
+     * @param key The key to find.
+     * @param value Receives the value paired with the key.
+     * @return True if this map contains the given key. Otherwise, returns false.
+     */
+    bool find(const std::string &key, ValueT &value) const noexcept;
+
+    /**
+     * Returns true if this map contains the given key. Otherwise, returns false.
+     *
+     * @param key The key to find.
+     * @return True if this map contains the given key. Otherwise, returns false.
+     */
+    bool containsKey(const std::string &key) const noexcept
+    {
+        ValueT value;
+        return find(key, value);
+    }
+
+    /**
+     * Returns (a copy of) the value paired with the given key, if it is in this map.
+     * Otherwise, throws exception.
+     *
+     * @param key The key to find.
+     * @throws KeyNotFoundException if key isn't in this map.
+     * @return The value paired with the given key.
+     */
+    ValueT at(const std::string &key) const
+    {
+        ValueT value;
+        if (!find(key, value))
+        {
+            throw KeyNotFoundException();
+        }
+        return value;
+    }
+
+    /**
+     * Returns true if insertion to this map is successful. Otherwise returns false.
+     * Failure to insert happens when key already exists in this map.
+     *
+     * @param key The key to insert.
+     * @param value The value to insert.
+     * @throws SharedMemoryException if this map is read-only or full.
+     * @return True if insertion to this map is successful. Otherwise returns false.
+     */
+    bool insert(const std::string &key, const ValueT &value);
+
+    /**
+     * Returns true if the given key was found in this map and its value replaced.
+     * Otherwise, returns false.
+     *
+     * @param key The key to find.
+     * @param value The new value.
+     * @throws SharedMemoryException if this map is read-only.
+     * @return True if the given key was found in this map.
+     */
+    bool update(const std::string &key, const ValueT &value);
+
+    /**
+     * Returns true if given key was found in this map and erases it. Otherwise, returns false.
+     *
+     * @param key The key to erase.
+     * @throws SharedMemoryException if this map is read-only.
+     * @return True if given key was found in this map and erases it. Otherwise, returns false.
+     */
+    bool erase(const std::string &key);
+
+    /**
+     * Clears this map from all elements.
+     *
+     * @throws SharedMemoryException if this map is read-only.
+     */
+    void clear();
+};
+
+// Private method that finds a key with plain reads that may race with the writer.
+template<typename ValueT>
+const typename SharedHashMap<ValueT>::Slot *
+SharedHashMap<ValueT>::_find(unsigned int region, const std::string &key, unsigned long long hash) const noexcept
+{
+    const Slot *slots = _slots(region);
+    unsigned long long mask = _header->slots - 1, arenaBytes = _header->arenaBytes;
+    for (unsigned long long i = hash & mask, probes = 0; probes <= mask; i = (i + 1) & mask, probes++)
+    {
+        unsigned int state = slots[i].state.load(std::memory_order_acquire);
+        if (state == SLOT_EMPTY)
+        {
+            return nullptr;
+        }
+
+        // Torn offsets are possible while the writer is active, so check bounds before comparing.
+        const Slot &slot = slots[i];
+        if (state == SLOT_FULL && slot.hash == hash && slot.keyLength == key.size() &&
+            slot.keyOffset <= arenaBytes && key.size() <= arenaBytes - slot.keyOffset &&
+            std::memcmp(_arena(region) + slot.keyOffset, key.data(), key.size()) == 0)
+        {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+// Private method that finds a key, or where to insert it, while holding the writer mutex.
+template<typename ValueT>
+typename SharedHashMap<ValueT>::Slot *
+SharedHashMap<ValueT>::_findForInsert(const std::string &key, unsigned long long hash) noexcept
+{
+    Slot *slots = _slots(_current()), *reusable = nullptr;
+    unsigned long long mask = _header->slots - 1;
+    for (unsigned long long i = hash & mask, probes = 0; probes <= mask; i = (i + 1) & mask, probes++)
+    {
+        unsigned int state = slots[i].state.load(std::memory_order_relaxed);
+        if (state == SLOT_EMPTY)
+        {
+            return (reusable != nullptr) ? reusable : &slots[i];
+        }
+        if (state == SLOT_ERASED)
+        {
+            reusable = (reusable != nullptr) ? reusable : &slots[i];
+        }
+        else if (slots[i].hash == hash && slots[i].keyLength == key.size() &&
+                 std::memcmp(_arena(_current()) + slots[i].keyOffset, key.data(), key.size()) == 0)
+        {
+            return &slots[i];
+        }
+    }
+    return reusable;
+}
+
+// Private method that empties a region readers don't use (readers that still read it will retry).
+template<typename ValueT>
+void SharedHashMap<ValueT>::_clearRegion(unsigned int region) noexcept
+{
+    // Punching out the pages frees them, and they read as zeros (empty slots) again.
+    if (madvise(_region(region), _header->regionBytes, MADV_REMOVE) != 0)
+    {
+        std::memset(_region(region), 0, _header->regionBytes);
+    }
+}
+
+// Private method that copies the live entries to the other region and switches to it (holding the
+// writer mutex). Readers keep using the current region until the switch.
+template<typename ValueT>
+void SharedHashMap<ValueT>::_compact() noexcept
+{
+    unsigned int from = _current(), to = 1 - from;
+    _clearRegion(to);
+    const Slot *source = _slots(from);
+    Slot *target = _slots(to);
+    unsigned long long mask = _header->slots - 1, arenaUsed = 0, used = 0;
+    for (unsigned long long j = 0; j < _header->slots; j++)
+    {
+        const Slot &entry = source[j];
+        if (entry.state.load(std::memory_order_relaxed) != SLOT_FULL)
+        {
+            continue;
+        }
+        unsigned long long i = entry.hash & mask;
+        while (target[i].state.load(std::memory_order_relaxed) != SLOT_EMPTY)
+        {
+            i = (i + 1) & mask;
+        }
+        std::memcpy(_arena(to) + arenaUsed, _arena(from) + entry.keyOffset, entry.keyLength);
+        target[i].hash = entry.hash;
+        target[i].keyOffset = arenaUsed;
+        target[i].keyLength = entry.keyLength;
+        target[i].value = entry.value;
+        target[i].state.store(SLOT_FULL, std::memory_order_relaxed);
+        arenaUsed += entry.keyLength;
+        used++;
+    }
+    _header->arenaUsed[to] = arenaUsed;
+    _header->used[to] = used;
+    {
+        _Publish publish(_header);
+        _header->region.store(to, std::memory_order_relaxed);
+    }
+    _clearRegion(from);
+}
+
+// Private method that maps a segment and points this map at it.
+template<typename ValueT>
+void SharedHashMap<ValueT>::_map(int fd, bool writable, unsigned long long bytes)
+{
+    _fd = fd;
+    _writable = writable;
+    struct stat status;
+    if (bytes == 0)
+    {
+        if (fstat(fd, &status) != 0 || (unsigned long long) status.st_size < sizeof(Header))
+        {
+            _release();
+            throw SharedMemoryException(ERROR_SHARED_OPEN);
+        }
+        bytes = status.st_size;
+    }
+
+    void *base = mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        _release();
+        throw SharedMemoryException(writable ? ERROR_SHARED_CREATE : ERROR_SHARED_OPEN);
+    }
+    _base = static_cast<char *>(base);
+    _bytes = bytes;
+    _header = reinterpret_cast<Header *>(_base);
+    if (!writable && (_header->magic != SHARED_MAGIC || _header->totalBytes != bytes))
+    {
+        _release();
+        throw SharedMemoryException(ERROR_SHARED_OPEN);
+    }
+}
+
+// Private method that lays out a new segment and initializes its process-shared mutex.
+template<typename ValueT>
+void SharedHashMap<ValueT>::_initialize(int capacity, unsigned long long arenaBytes)
+{
+    unsigned long long slots = DEFAULT_CAPACITY;
+    while (slots * MAX_LOAD_FACTOR < (unsigned long long) capacity)
+    {
+        slots *= CHANGE_FACTOR;
+    }
+    if (arenaBytes == 0)
+    {
+        arenaBytes = (unsigned long long) capacity * SHARED_KEY_BYTES;
+    }
+    // Regions start on pages of their own, so that an unused one can be released.
+    unsigned long long page = sysconf(_SC_PAGESIZE);
+    unsigned long long firstRegion = (sizeof(Header) + page - 1) / page * page;
+    unsigned long long arenaOffset = _align(slots * sizeof(Slot));
+    unsigned long long regionBytes = (arenaOffset + arenaBytes + page - 1) / page * page;
+    unsigned long long totalBytes = firstRegion + SHARED_REGIONS * regionBytes;
+    if (capacity <= 0 || ftruncate(_fd, totalBytes) != 0)
+    {
+        _release();
+        throw SharedMemoryException(ERROR_SHARED_CREATE);
+    }
+    _map(_fd, true, totalBytes); // New pages read as zeros, so every slot starts empty.
+
+    _header->slots = slots;
+    _header->capacity = capacity;
+    _header->firstRegion = firstRegion;
+    _header->regionBytes = regionBytes;
+    _header->arenaOffset = arenaOffset;
+    _header->arenaBytes = arenaBytes;
+    _header->totalBytes = totalBytes;
+    for (int region = 0; region < SHARED_REGIONS; region++)
+    {
+        _header->arenaUsed[region] = 0;
+        _header->used[region] = 0;
+    }
+    new(&_header->region) std::atomic<unsigned int>(0);
+    new(&_header->size) std::atomic<long long>(0);
+    new(&_header->sequence) std::atomic<unsigned long long>(0);
+
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&_header->writer, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+
+    std::atomic_thread_fence(std::memory_order_release);
+    _header->magic = SHARED_MAGIC; // Last, so that readers never open a half-made segment.
+}
+
+// Private method that unmaps and closes the segment.
+template<typename ValueT>
+void SharedHashMap<ValueT>::_release() noexcept
+{
+    if (_base != nullptr)
+    {
+        munmap(_base, _bytes);
+    }
+    if (_fd >= 0)
+    {
+        close(_fd);
+    }
+    _fd = -1;
+    _base = nullptr;
+    _header = nullptr;
+}
+
+/**
+ * Creates a new named segment (replacing a segment of the same name) that can hold the given
+ * number of entries and key bytes, and maps it for writing.
+ *
+ * @param name The name of the segment, starting with '/'.
+ * @param capacity How many entries the map can hold.
+ * @param arenaBytes How many bytes of keys the map can hold (0 for SHARED_KEY_BYTES per entry).
+ * @throws SharedMemoryException if the segment can't be created.
+ * @return The writer of the new map.
+ */
+template<typename ValueT>
+SharedHashMap<ValueT> SharedHashMap<ValueT>::create(const std::string &name, int capacity,
+                                                    unsigned long long arenaBytes)
+{
+    shm_unlink(name.c_str()); // Readers of a replaced segment keep it until they reopen.
+    SharedHashMap map;
+    map._fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (map._fd < 0)
+    {
+        throw SharedMemoryException(ERROR_SHARED_CREATE);
+    }
+    map._initialize(capacity, arenaBytes);
+    return map;
+}
+
+/**
+ * Creates a new anonymous (memfd) segment, which is shared by passing fd() to other processes,
+ * and maps it for writing.
+ *
+ * @param capacity How many entries the map can hold.
+ * @param arenaBytes How many bytes of keys the map can hold (0 for SHARED_KEY_BYTES per entry).
+ * @throws SharedMemoryException if the segment can't be created.
+ * @return The writer of the new map.
+ */
+template<typename ValueT>
+SharedHashMap<ValueT> SharedHashMap<ValueT>::createAnonymous(int capacity, unsigned long long arenaBytes)
+{
+    SharedHashMap map;
+    map._fd = memfd_create("SharedHashMap", 0); // Inherited by children, so no close-on-exec.
+    if (map._fd < 0)
+    {
+        throw SharedMemoryException(ERROR_SHARED_CREATE);
+    }
+    map._initialize(capacity, arenaBytes);
+    return map;
+}
+
+/**
+ * Opens an existing named segment for reading.
+ *
+ * @param name The name of the segment.
+ * @throws SharedMemoryException if the segment doesn't exist or isn't a SharedHashMap.
+ * @return A reader of the map.
+ */
+template<typename ValueT>
+SharedHashMap<ValueT> SharedHashMap<ValueT>::open(const std::string &name)
+{
+    SharedHashMap map;
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        throw SharedMemoryException(ERROR_SHARED_OPEN);
+    }
+    map._map(fd, false, 0);
+    return map;
+}
+
+/**
+ * Opens an existing segment from a descriptor (such as an inherited fd()) for reading.
+ * The descriptor is duplicated, so the caller keeps its own.
+ *
+ * @param fd The descriptor of the segment.
+ * @throws SharedMemoryException if the descriptor isn't a SharedHashMap segment.
+ * @return A reader of the map.
+ */
+template<typename ValueT>
+SharedHashMap<ValueT> SharedHashMap<ValueT>::open(int fd)
+{
+    SharedHashMap map;
+    int copy = dup(fd);
+    if (copy < 0)
+    {
+        throw SharedMemoryException(ERROR_SHARED_OPEN);
+    }
+    map._map(copy, false, 0);
+    return map;
+}
+
+/**
+ * Returns true and copies the value paired with the given key, if it is in this map.
+ * Otherwise, returns false.
+ *
+ * @param key The key to find.
+ * @param value Receives the value paired with the key.
+ * @return True if this map contains the given key. Otherwise, returns false.
+ */
+template<typename ValueT>
+bool SharedHashMap<ValueT>::find(const std::string &key, ValueT &value) const noexcept
+{
+    unsigned long long hash = std::hash<std::string>{}(key);
+    for (int spins = 0;; spins++)
+    {
+        unsigned long long sequence = _header->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) // An update is being published.
+        {
+            if (spins >= SHARED_READ_SPINS) // Let the writer run (it may share this CPU).
+            {
+                sched_yield();
+            }
+            continue;
+        }
+        const Slot *slot = _find(_header->region.load(std::memory_order_acquire), key, hash);
+        if (slot != nullptr)
+        {
+            std::memcpy(&value, &slot->value, sizeof(ValueT));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_header->sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return slot != nullptr;
+        }
+    }
+}
+
+/**
+ * Returns true if insertion to this map is successful. Otherwise returns false.
+ * Failure to insert happens when key already exists in this map.
+ *
+ * @param key The key to insert.
+ * @param value The value to insert.
+ * @throws SharedMemoryException if this map is read-only or full.
+ * @return True if insertion to this map is successful. Otherwise returns false.
+ */
+template<typename ValueT>
+bool SharedHashMap<ValueT>::insert(const std::string &key, const ValueT &value)
+{
+    if (!_writable)
+    {
+        throw SharedMemoryException(ERROR_SHARED_READ_ONLY);
+    }
+
+    unsigned long long hash = std::hash<std::string>{}(key);
+    _WriterLock lock(_header);
+    Slot *slot = _findForInsert(key, hash);
+    if (slot != nullptr && slot->state.load(std::memory_order_relaxed) == SLOT_FULL)
+    {
+        return false;
+    }
+    if ((unsigned long long) size() >= _header->capacity || key.size() > _header->arenaBytes)
+    {
+        throw SharedMemoryException(ERROR_SHARED_FULL);
+    }
+
+    bool fresh = slot == nullptr || slot->state.load(std::memory_order_relaxed) == SLOT_EMPTY;
+    if ((fresh && _header->used[_current()] >= _header->slots * MAX_LOAD_FACTOR) ||
+        key.size() > _header->arenaBytes - _header->arenaUsed[_current()])
+    {
+        _compact();
+        if (key.size() > _header->arenaBytes - _header->arenaUsed[_current()])
+        {
+            throw SharedMemoryException(ERROR_SHARED_FULL);
+        }
+        slot = _findForInsert(key, hash);
+        fresh = slot->state.load(std::memory_order_relaxed) == SLOT_EMPTY;
+    }
+
+    // The key's bytes are claimed before the slot points at them, so a writer that dies in
+    // between only leaks them.
+    unsigned int region = _current();
+    unsigned long long keyOffset = _header->arenaUsed[region];
+    std::memcpy(_arena(region) + keyOffset, key.data(), key.size());
+    _header->arenaUsed[region] += key.size();
+    _header->used[region] += fresh;
+    {
+        _Publish publish(_header);
+        slot->hash = hash;
+        slot->keyOffset = keyOffset;
+        slot->keyLength = key.size();
+        slot->value = value;
+        slot->state.store(SLOT_FULL, std::memory_order_release);
+    }
+    _header->size.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Returns true if the given key was found in this map and its value replaced.
+ * Otherwise, returns false.
+ *
+ * @param key The key to find.
+ * @param value The new value.
+ * @throws SharedMemoryException if this map is read-only.
+ * @return True if the given key was found in this map.
+ */
+template<typename ValueT>
+bool SharedHashMap<ValueT>::update(const std::string &key, const ValueT &value)
+{
+    if (!_writable)
+    {
+        throw SharedMemoryException(ERROR_SHARED_READ_ONLY);
+    }
+
+    _WriterLock lock(_header);
+    Slot *slot = _findForInsert(key, std::hash<std::string>{}(key));
+    if (slot == nullptr || slot->state.load(std::memory_order_relaxed) != SLOT_FULL)
+    {
+        return false;
+    }
+    _Publish publish(_header);
+    slot->value = value;
+    return true;
+}
+
+/**
+ * Returns true if given key was found in this map and erases it. Otherwise, returns false.
+ *
+ * @param key The key to erase.
+ * @throws SharedMemoryException if this map is read-only.
+ * @return True if given key was found in this map and erases it. Otherwise, returns false.
+ */
+template<typename ValueT>
+bool SharedHashMap<ValueT>::erase(const std::string &key)
+{
+    if (!_writable)
+    {
+        throw SharedMemoryException(ERROR_SHARED_READ_ONLY);
+    }
+
+    _WriterLock lock(_header);
+    Slot *slot = _findForInsert(key, std::hash<std::string>{}(key));
+    if (slot == nullptr || slot->state.load(std::memory_order_relaxed) != SLOT_FULL)
+    {
+        return false;
+    }
+    _Publish publish(_header);
+    slot->state.store(SLOT_ERASED, std::memory_order_release);
+    _header->size.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Clears this map from all elements.
+ *
+ * @throws SharedMemoryException if this map is read-only.
+ */
+template<typename ValueT>
+void SharedHashMap<ValueT>::clear()
+{
+    if (!_writable)
+    {
+        throw SharedMemoryException(ERROR_SHARED_READ_ONLY);
+    }
+
+    _WriterLock lock(_header);
+    unsigned int from = _current(), to = 1 - from;
+    _clearRegion(to);
+    _header->arenaUsed[to] = 0;
+    _header->used[to] = 0;
+    {
+        _Publish publish(_header);
+        _header->region.store(to, std::memory_order_relaxed);
+        _header->size.store(0, std::memory_order_relaxed);
+    }
+    _clearRegion(from);
+}
+
+#endif //SPAMDETECTOR_SHAREDHASHMAP_HPP
@@ -0,0 +1,266 @@
+/**
+ * @file SpamBenchmark.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief End-to-end benchmark of the SpamDetector and its matching engines.
+ *
+ * @section DESCRIPTION
+ * This file generates phrase databases of several shapes and a message, times every matching
+ * engine on the message in process (checking that they agree on the score), and times whole
+ * runs of the SpamDetector program on the generated files.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <spawn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "BenchUtils.hpp"
+#include "BenchReport.hpp"
+#include "Matcher.hpp"
+
+#define USAGE_MSG "Usage: SpamBenchmark [phrases] [message KB] [repetitions] [--json <path>]"
+#define BENCHMARK_NAME "SpamBenchmark"
+#define DETECTOR_NAME "SpamDetector"
+#define TEMP_TEMPLATE "/tmp/SpamBenchmarkXXXXXX"
+#define DATABASE_FILE "/database.csv"
+#define MESSAGE_FILE "/message.txt"
+#define THRESHOLD "1"
+#define SEPARATOR_CHAR ','
+#define PHRASES_INDEX 1
+#define MESSAGE_INDEX 2
+#define REPETITIONS_INDEX 3
+#define DEFAULT_PHRASES 2000
+#define DEFAULT_MESSAGE_KB 256
+#define DEFAULT_REPETITIONS 5
+#define KILOBYTE 1024
+#define FEW_PHRASES 5
+#define VOCABULARY 5000
+#define MAX_SCORE 10
+#define LINE_WORDS 12
+#define PHRASE_ODDS 20
+#define NAME_WIDTH 12
+#define NUMBER_WIDTH 14
+
+/**
+ * Shape of a generated database: how many phrases, of how many words, of which lengths.
+ */
+struct DatabaseShape
+{
+    const char *name;
+    int phrases, minWords, maxWords, minLength, maxLength;
+};
+
+// Returns a random lowercase word with a length in [minLength, maxLength].
+static std::string randomWord(std::mt19937 &random, int minLength, int maxLength)
+{
+    std::uniform_int_distribution<int> length(minLength, maxLength), letter(0, LETTERS - 1);
+    std::string word(length(random), FIRST_LETTER);
+    for (char &ch : word)
+    {
+        ch = (char) (FIRST_LETTER + letter(random));
+    }
+    return word;
+}
+
+// Generates distinct phrases of the given shape with scores, and writes them as a CSV database.
+static void makeDatabase(const DatabaseShape &shape, const std::string &path, std::vector<std::string> &phrases,
+                         std::vector<int> &scores)
+{
+    std::mt19937 random(shape.phrases);
+    std::uniform_int_distribution<int> words(shape.minWords, shape.maxWords), score(1, MAX_SCORE);
+    HashMap<std::string, int> seen;
+    std::ofstream out(path);
+    while ((int) phrases.size() < shape.phrases)
+    {
+        std::string phrase = randomWord(random, shape.minLength, shape.maxLength);
+        for (int i = words(random); i > 1; i--)
+        {
+            phrase += " " + randomWord(random, shape.minLength, shape.maxLength);
+        }
+        if (seen.insert(phrase, 0))
+        {
+            phrases.push_back(phrase);
+            scores.push_back(score(random));
+            out << phrase << SEPARATOR_CHAR << scores.back() << "\n";
+        }
+    }
+}
+
+// Generates a message of about the given size, sprinkled with phrases, and writes it to a file.
+static std::vector<std::string> makeMessage(const std::vector<std::string> &phrases, int kilobytes,
+                                            const std::string &path)
+{
+    std::mt19937 random(kilobytes);
+    std::vector<std::string> vocabulary, lines;
+    for (int i = 0; i < VOCABULARY; i++)
+    {
+        vocabulary.push_back(randomWord(random, 2, 10));
+    }
+    std::uniform_int_distribution<int> word(0, VOCABULARY - 1), phrase(0, (int) phrases.size() - 1),
+            odds(0, PHRASE_ODDS - 1);
+
+    std::ofstream out(path);
+    long long size = 0;
+    while (size < (long long) kilobytes * KILOBYTE)
+    {
+        std::string line;
+        for (int i = 0; i < LINE_WORDS; i++)
+        {
+            line += (odds(random) == 0) ? phrases[phrase(random)] : vocabulary[word(random)];
+            line += " ";
+        }
+        out << line << "\n";
+        size += line.size() + 1;
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Runs the SpamDetector program on the given files and returns its wall time in milliseconds, or -1.
+static double runDetector(const std::string &detector, const std::string &database, const std::string &message)
+{
+    std::vector<std::string> args = {detector, database, message, THRESHOLD};
+    std::vector<char *> argv;
+    for (std::string &arg : args)
+    {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    int status = -1;
+    bool ok = posix_spawn(&pid, detector.c_str(), &actions, nullptr, argv.data(), environ) == 0 &&
+              waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    posix_spawn_file_actions_destroy(&actions);
+    return ok ? milliseconds : -1;
+}
+
+// Times an engine on the message lines, records and prints its throughput, and returns its score.
+static int measureEngine(BenchReport &report, const DatabaseShape &shape, const Matcher &matcher,
+                         const std::vector<std::string> &lines, int repetitions, bool selected)
+{
+    long long bytes = 0;
+    for (const std::string &line : lines)
+    {
+        bytes += line.size();
+    }
+
+    int score = 0;
+    std::vector<double> &samples = report.samples(std::string(shape.name) + "/" + matcher.name(), "MB/s", false);
+    for (int i = 0; i < repetitions; i++)
+    {
+        score = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string &line : lines)
+        {
+            score += matcher.score(line);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        samples.push_back(bytes / seconds / (KILOBYTE * KILOBYTE));
+    }
+
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    std::cout << std::left << std::setw(NAME_WIDTH) << shape.name << std::setw(NAME_WIDTH) << matcher.name()
+              << std::right << std::fixed << std::setprecision(2) << std::setw(NUMBER_WIDTH)
+              << sorted[sorted.size() / 2] << std::setw(NUMBER_WIDTH) << score
+              << std::setw(NUMBER_WIDTH) << (selected ? "selected" : "") << std::endl;
+    return score;
+}
+
+/**
+ * Program's main that receives an optional phrase count, message size and repetition count,
+ * and prints the median throughput of every engine and the median wall time of whole
+ * SpamDetector runs for every database shape.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    BenchReport report(BENCHMARK_NAME, argc, argv);
+    int phrases = (argc > PHRASES_INDEX) ? std::atoi(argv[PHRASES_INDEX]) : DEFAULT_PHRASES;
+    int kilobytes = (argc > MESSAGE_INDEX) ? std::atoi(argv[MESSAGE_INDEX]) : DEFAULT_MESSAGE_KB;
+    int repetitions = (argc > REPETITIONS_INDEX) ? std::atoi(argv[REPETITIONS_INDEX]) : DEFAULT_REPETITIONS;
+    char directory[] = TEMP_TEMPLATE;
+    if (argc > REPETITIONS_INDEX + 1 || phrases <= FEW_PHRASES || kilobytes <= 0 || repetitions <= 0 ||
+        mkdtemp(directory) == nullptr)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string self(argv[0]), database = std::string(directory) + DATABASE_FILE,
+            message = std::string(directory) + MESSAGE_FILE;
+    std::string::size_type slash = self.rfind('/');
+    std::string detector = ((slash == std::string::npos) ? std::string(".") : self.substr(0, slash)) + "/" +
+                           DETECTOR_NAME;
+
+    const DatabaseShape shapes[] = {{"few",   FEW_PHRASES, 2, 4, 3, 10},
+                                    {"words", phrases,     1, 1, 4, 6},
+                                    {"mixed", phrases,     1, 3, 2, 12}};
+    std::cout << std::left << std::setw(NAME_WIDTH) << "database" << std::setw(NAME_WIDTH) << "engine"
+              << std::right << std::setw(NUMBER_WIDTH) << "MB/s" << std::setw(NUMBER_WIDTH) << "score" << std::endl;
+    bool agree = true;
+    for (const DatabaseShape &shape : shapes)
+    {
+        std::vector<std::string> keys;
+        std::vector<int> scores;
+        makeDatabase(shape, database, keys, scores);
+        std::vector<std::string> lines = makeMessage(keys, kilobytes, message);
+
+        HashMap<std::string, int> map(keys, scores);
+        std::unique_ptr<Matcher> selected = selectMatcher(map);
+        SubstringMatcher substring(map);
+        AutomatonMatcher automaton(map);
+        HashingMatcher hashing(map);
+        int expected = measureEngine(report, shape, substring, lines, repetitions,
+                                     std::string(selected->name()) == substring.name());
+        agree = agree && measureEngine(report, shape, automaton, lines, repetitions,
+                                       std::string(selected->name()) == automaton.name()) == expected;
+        agree = agree && measureEngine(report, shape, hashing, lines, repetitions,
+                                       std::string(selected->name()) == hashing.name()) == expected;
+
+        std::vector<double> &samples = report.samples(std::string(shape.name) + "/end-to-end", "ms", true);
+        for (int i = 0; i < repetitions; i++)
+        {
+            double milliseconds = runDetector(detector, database, message);
+            if (milliseconds >= 0)
+            {
+                samples.push_back(milliseconds);
+            }
+        }
+        if (!samples.empty())
+        {
+            std::vector<double> sorted(samples);
+            std::sort(sorted.begin(), sorted.end());
+            std::cout << std::left << std::setw(NAME_WIDTH) << shape.name << std::setw(NAME_WIDTH) << DETECTOR_NAME
+                      << std::right << std::setw(NUMBER_WIDTH) << sorted[sorted.size() / 2] << " ms" << std::endl;
+        }
+    }
+
+    unlink(database.c_str());
+    unlink(message.c_str());
+    rmdir(directory);
+    if (!agree)
+    {
+        std::cerr << "Engines disagree on the score." << std::endl;
+        return EXIT_FAILURE;
+    }
+    return report.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -14,7 +14,9 @@
 #include <boost/filesystem.hpp>
 #include <boost/tokenizer.hpp>
 #include <vector>
+#include <memory>
 #include "HashMap.hpp"
+#include "Matcher.hpp"
 
 // Constants.
 #define USAGE_MSG "Usage: SpamDetector <database path> <message path> <threshold>"
@@ -27,7 +29,6 @@
 #define DATABASE_INDEX 1
 #define MESSAGE_INDEX 2
 #define THRESHOLD_INDEX 3
-#define FAILURE -1
 
 const char CAPS_MIN = 'A', CAPS_MAX = 'Z';
 
@@ -71,13 +72,6 @@ static std::string &_toLowercase(std::string &st)
     return st;
 }
 
-// Returns copy of const string in lowercase.
-static std::string _toLowercase(const std::string &st)
-{
-    std::string copy(st);
-    return _toLowercase(copy);
-}
-
 /*
  * Reads a CSV file and loads the phrases and scores into two vectors in the correct order.
  *
@@ -113,7 +107,8 @@ loadDatabase(const char *pathString, std::vector<std::string> &phrases, std::vec
             throw BadInputException();
         }
 
-        phrases.push_back(_toLowercase(*it));
+        phrases.push_back(*it);
+        _toLowercase(phrases.back());
         if (++it == tok.end() || !_isNonNegativeNumber(*it))
         {
             throw BadInputException();
@@ -129,13 +124,13 @@ loadDatabase(const char *pathString, std::vector<std::string> &phrases, std::vec
 }
 
 /*
- * Scores an email according to given database and returns the score.
+ * Scores an email according to given matcher and returns the score.
  *
  * @param pathString The path to the email file.
- * @param database A HashMap that maps from bad phrases to scores.
+ * @param matcher A Matcher built from the database of bad phrases and scores.
  * @return The score the email got.
  */
-static int scoreEmail(const char *pathString, HashMap<std::string, int> &database)
+static int scoreEmail(const char *pathString, const Matcher &matcher)
 {
     boost::filesystem::path p(pathString);
     if (!boost::filesystem::exists(p))
@@ -150,17 +145,7 @@ static int scoreEmail(const char *pathString, HashMap<std::string, int> &databas
     {
         if (!line.empty())
         {
-            _toLowercase(line);
-            for (const std::pair<std::string, int> &pair : database)
-            {
-                int phraseIndex = line.find(pair.first);
-                while (phraseIndex != FAILURE)
-                {
-                    line.replace(phraseIndex, pair.first.size(), SEPARATOR);
-                    score += pair.second;
-                    phraseIndex = line.find(pair.first, phraseIndex);
-                }
-            }
+            score += matcher.score(_toLowercase(line));
         }
     }
     return score;
@@ -198,7 +183,9 @@ int main(int argc, char **argv)
         loadDatabase(argv[DATABASE_INDEX], phrases, scores);
         HashMap<std::string, int> database(phrases, scores);
 
-        int score = scoreEmail(argv[MESSAGE_INDEX], database);
+        std::unique_ptr<Matcher> matcher = selectMatcher(database);
+
+        int score = scoreEmail(argv[MESSAGE_INDEX], *matcher);
         std::cout << ((score >= threshold) ? SPAM : NOT_SPAM) << std::endl;
     }
     catch (BadInputException &e)
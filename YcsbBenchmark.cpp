@@ -0,0 +1,433 @@
+/**
+ * @file YcsbBenchmark.cpp
+ * @author  Jason Elter <jason.elter@mail.huji.ac.il>
+ * @version 1.0
+ * @date 18 October 2026
+ *
+ * @brief YCSB-style concurrent mixed-workload benchmark for the HashMap variants.
+ *
+ * @section DESCRIPTION
+ * This file drives a map from several threads with a configurable mix of reads, updates, inserts
+ * and deletes, over uniform, Zipfian or latest key distributions, and reports the throughput and
+ * latency percentiles (and hardware counters per operation, when available) for every thread count
+ * and key-space size.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include "BenchUtils.hpp"
+#include "PerfCounters.hpp"
+#include "BenchReport.hpp"
+#include "HashMap.hpp"
+#include "ConcurrentHashMap.hpp"
+
+#define USAGE_MSG "Usage: YcsbBenchmark [workload] [max threads] [keys,...] [ops per thread] [--json <path>]\n" \
+                  "workload is all, A, B, C, D, W or read:update:insert:delete:distribution " \
+                  "(e.g. 50:40:5:5:zipfian)"
+#define BENCHMARK_NAME "YcsbBenchmark"
+#define WORKLOAD_INDEX 1
+#define THREADS_INDEX 2
+#define KEYS_INDEX 3
+#define OPS_INDEX 4
+#define MAX_ARGS 5
+#define ALL_WORKLOADS "all"
+#define DEFAULT_KEYS 100000
+#define DEFAULT_OPS 200000
+#define SPEC_SEPARATOR ':'
+#define LIST_SEPARATOR ','
+#define SPEC_FIELDS 5
+#define PERCENT 100
+#define NAME_WIDTH 24
+#define NUMBER_WIDTH 12
+
+const double ZIPFIAN_CONSTANT = 0.99, P50 = 0.5, P99 = 0.99, P999 = 0.999;
+
+/**
+ * Key distributions of a workload.
+ */
+enum Distribution
+{
+    UNIFORM, ZIPFIAN, LATEST
+};
+
+/**
+ * A mix of operations and the distribution of the keys they touch.
+ */
+struct Workload
+{
+    std::string name;
+    int read, update, insert, erase; // Percentages.
+    Distribution distribution;
+};
+
+/**
+ * Zipfian generator of items in [0, count), following Gray et al. as done by YCSB.
+ * Item 0 is the most popular.
+ */
+class ZipfianGenerator
+{
+    long long _count;
+    double _theta, _alpha, _zetan, _eta;
+
+public:
+    /**
+     * Creates a new generator over the given number of items.
+     *
+     * @param count The number of items.
+     * @param theta The skew of the distribution.
+     */
+    explicit ZipfianGenerator(long long count, double theta = ZIPFIAN_CONSTANT) : _count(count), _theta(theta)
+    {
+        double zeta2 = 1 + std::pow(0.5, theta);
+        _zetan = 0;
+        for (long long i = 1; i <= count; i++)
+        {
+            _zetan += 1 / std::pow((double) i, theta);
+        }
+        _alpha = 1 / (1 - theta);
+        _eta = (1 - std::pow(2.0 / count, 1 - theta)) / (1 - zeta2 / _zetan);
+    }
+
+    /**
+     * Returns the next item for the given uniform number in [0, 1).
+     *
+     * @param u A uniform number in [0, 1).
+     * @return The next item.
+     */
+    long long next(double u) const noexcept
+    {
+        double uz = u * _zetan;
+        if (uz < 1)
+        {
+            return 0;
+        }
+        if (uz < 1 + std::pow(0.5, _theta))
+        {
+            return 1;
+        }
+        return std::min(_count - 1, (long long) (_count * std::pow(_eta * u - _eta + 1, _alpha)));
+    }
+};
+
+/**
+ * The HashMap behind a single mutex.
+ * Every store driven by this benchmark has a name and thread-safe read, update, insert and erase.
+ */
+class LockedHashMap
+{
+    HashMap<long long, long long> _map;
+    std::mutex _mutex;
+
+public:
+    static const char *name()
+    {
+        return "HashMap+mutex";
+    }
+
+    bool read(long long key)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _map.containsKey(key);
+    }
+
+    void update(long long key, long long value)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _map[key] = value;
+    }
+
+    void insert(long long key, long long value)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _map.insert(key, value);
+    }
+
+    void erase(long long key)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _map.erase(key);
+    }
+};
+
+/**
+ * The ConcurrentHashMap, with per-bucket locks and cooperative resizing.
+ */
+class ConcurrentStore
+{
+    ConcurrentHashMap<long long, long long> _map;
+
+public:
+    static const char *name()
+    {
+        return "ConcurrentHashMap";
+    }
+
+    bool read(long long key)
+    {
+        return _map.containsKey(key);
+    }
+
+    void update(long long key, long long value)
+    {
+        _map.put(key, value);
+    }
+
+    void insert(long long key, long long value)
+    {
+        _map.insert(key, value);
+    }
+
+    void erase(long long key)
+    {
+        _map.erase(key);
+    }
+};
+
+/**
+ * Results of a single run.
+ */
+struct RunResult
+{
+    double throughput;
+    long long p50, p99, p999, max; // Nanoseconds.
+    PerfSample counters;
+};
+
+/*
+ * Runs ops operations of a workload from a single thread and records their latencies.
+ * inserted counts the keys inserted so far (by all threads).
+ */
+template<typename Store>
+static void runWorker(Store &store, const Workload &workload, const ZipfianGenerator &zipfian,
+                      std::atomic<long long> &inserted, int seed, long long ops, std::vector<long long> &samples)
+{
+    std::mt19937_64 random(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::uniform_int_distribution<int> percent(0, PERCENT - 1);
+    samples.reserve(ops);
+    for (long long i = 0; i < ops; i++)
+    {
+        long long count = inserted.load(std::memory_order_relaxed), item;
+        switch (workload.distribution)
+        {
+            case ZIPFIAN:
+                item = benchMix(zipfian.next(uniform(random))) % count; // Scatter the hot items.
+                break;
+            case LATEST:
+                item = std::max(0LL, count - 1 - zipfian.next(uniform(random)));
+                break;
+            default:
+                item = (long long) (uniform(random) * count);
+        }
+
+        int choice = percent(random);
+        auto start = std::chrono::steady_clock::now();
+        if ((choice -= workload.read) < 0)
+        {
+            store.read((long long) benchMix(item));
+        }
+        else if ((choice -= workload.update) < 0)
+        {
+            store.update((long long) benchMix(item), i);
+        }
+        else if ((choice -= workload.insert) < 0)
+        {
+            store.insert((long long) benchMix(inserted.fetch_add(1, std::memory_order_relaxed)), i);
+        }
+        else
+        {
+            store.erase((long long) benchMix(item));
+        }
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+/*
+ * Runs a workload with the given number of threads against a new store preloaded with keys items,
+ * and returns its throughput and latency percentiles.
+ */
+template<typename Store>
+static RunResult runWorkload(PerfCounters &counters, const Workload &workload, int threads, long long keys,
+                             long long ops)
+{
+    Store store;
+    for (long long i = 0; i < keys; i++)
+    {
+        store.insert((long long) benchMix(i), i);
+    }
+
+    ZipfianGenerator zipfian(keys);
+    std::atomic<long long> inserted(keys);
+    std::vector<std::vector<long long>> latencies(threads);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    counters.start();
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back(runWorker<Store>, std::ref(store), std::cref(workload), std::cref(zipfian),
+                             std::ref(inserted), t + 1, ops, std::ref(latencies[t]));
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    PerfSample sample = counters.stop();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<long long> all;
+    for (const std::vector<long long> &samples : latencies)
+    {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p)
+    { return all[std::min(all.size() - 1, (size_t) (p * all.size()))]; };
+    return {all.size() / seconds, percentile(P50), percentile(P99), percentile(P999), all.back(), sample};
+}
+
+// Runs a workload for thread counts 1, 2, 4, ... up to maxThreads and prints a line for each.
+template<typename Store>
+static void runAll(PerfCounters &counters, BenchReport &report, const Workload &workload, int maxThreads,
+                   long long keys, long long ops)
+{
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    for (int threads : threadCounts)
+    {
+        RunResult result = runWorkload<Store>(counters, workload, threads, keys, ops);
+        std::string name = std::string(Store::name()) + "/" + workload.name + "/" + std::to_string(threads) +
+                           "t/" + std::to_string(keys) + "/";
+        report.add(name + "throughput", "ops/s", false, result.throughput);
+        report.add(name + "p50", "ns", true, result.p50);
+        report.add(name + "p99", "ns", true, result.p99);
+        report.add(name + "p99.9", "ns", true, result.p999);
+        std::cout << std::left << std::setw(NAME_WIDTH) << Store::name() << std::setw(NAME_WIDTH) << workload.name
+                  << std::right << std::setw(NUMBER_WIDTH) << threads << std::setw(NUMBER_WIDTH) << keys
+                  << std::fixed << std::setprecision(0) << std::setw(NUMBER_WIDTH) << result.throughput
+                  << std::setw(NUMBER_WIDTH) << result.p50 << std::setw(NUMBER_WIDTH) << result.p99
+                  << std::setw(NUMBER_WIDTH) << result.p999 << std::setw(NUMBER_WIDTH) << result.max
+                  << result.counters.perOperation(threads * ops, NUMBER_WIDTH) << std::endl;
+    }
+}
+
+/*
+ * Parses a workload preset name or a read:update:insert:delete:distribution spec.
+ * Returns false if it is invalid.
+ */
+static bool parseWorkload(const std::string &spec, Workload &workload)
+{
+    static const Workload presets[] = {{"A", 50, 50, 0, 0, ZIPFIAN},
+                                       {"B", 95, 5,  0, 0, ZIPFIAN},
+                                       {"C", 100, 0, 0, 0, ZIPFIAN},
+                                       {"D", 95, 0,  5, 0, LATEST},
+                                       {"W", 50, 0, 25, 25, UNIFORM}};
+    for (const Workload &preset : presets)
+    {
+        if (spec == preset.name)
+        {
+            workload = preset;
+            return true;
+        }
+    }
+
+    std::vector<std::string> fields;
+    std::stringstream stream(spec);
+    for (std::string field; std::getline(stream, field, SPEC_SEPARATOR);)
+    {
+        fields.push_back(field);
+    }
+    if (fields.size() != SPEC_FIELDS)
+    {
+        return false;
+    }
+
+    workload.name = spec;
+    workload.read = std::atoi(fields[0].c_str());
+    workload.update = std::atoi(fields[1].c_str());
+    workload.insert = std::atoi(fields[2].c_str());
+    workload.erase = std::atoi(fields[3].c_str());
+    const std::string &distribution = fields[4];
+    workload.distribution = (distribution == "zipfian") ? ZIPFIAN : (distribution == "latest") ? LATEST : UNIFORM;
+    return workload.read >= 0 && workload.update >= 0 && workload.insert >= 0 && workload.erase >= 0 &&
+           workload.read + workload.update + workload.insert + workload.erase == PERCENT &&
+           (workload.distribution != UNIFORM || distribution == "uniform");
+}
+
+/**
+ * Program's main that receives an optional workload, maximal thread count, key-space size and
+ * number of operations per thread, and prints the results of every run.
+ *
+ * @param argc Count of args.
+ * @param argv Args values.
+ * @return Program exit status code.
+ */
+int main(int argc, char **argv)
+{
+    BenchReport report(BENCHMARK_NAME, argc, argv);
+    std::string spec = (argc > WORKLOAD_INDEX) ? argv[WORKLOAD_INDEX] : ALL_WORKLOADS;
+    int maxThreads = (argc > THREADS_INDEX) ? std::atoi(argv[THREADS_INDEX]) :
+                     std::max(1, (int) std::thread::hardware_concurrency());
+    std::vector<long long> keySpaces;
+    std::stringstream keysStream((argc > KEYS_INDEX) ? argv[KEYS_INDEX] : std::to_string(DEFAULT_KEYS));
+    for (std::string field; std::getline(keysStream, field, LIST_SEPARATOR);)
+    {
+        keySpaces.push_back(std::atoll(field.c_str()));
+    }
+    long long ops = (argc > OPS_INDEX) ? std::atoll(argv[OPS_INDEX]) : DEFAULT_OPS;
+
+    std::vector<Workload> workloads;
+    for (const char *name : {"A", "B", "C", "D", "W"})
+    {
+        Workload workload;
+        if ((spec == ALL_WORKLOADS || spec == name) && parseWorkload(name, workload))
+        {
+            workloads.push_back(workload);
+        }
+    }
+    Workload custom;
+    if (workloads.empty() && parseWorkload(spec, custom))
+    {
+        workloads.push_back(custom);
+    }
+
+    if (argc > MAX_ARGS || workloads.empty() || maxThreads <= 0 || keySpaces.empty() || ops <= 0 ||
+        *std::min_element(keySpaces.begin(), keySpaces.end()) <= 1)
+    {
+        std::cerr << USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    PerfCounters counters;
+    if (!counters.available())
+    {
+        std::cerr << "Hardware counters are not available; reporting times only." << std::endl;
+    }
+    std::cout << std::left << std::setw(NAME_WIDTH) << "store" << std::setw(NAME_WIDTH) << "workload"
+              << std::right << std::setw(NUMBER_WIDTH) << "threads" << std::setw(NUMBER_WIDTH) << "keys"
+              << std::setw(NUMBER_WIDTH) << "ops/s" << std::setw(NUMBER_WIDTH) << "p50 ns"
+              << std::setw(NUMBER_WIDTH) << "p99 ns" << std::setw(NUMBER_WIDTH) << "p99.9 ns"
+              << std::setw(NUMBER_WIDTH) << "max ns" << PerfCounters::names(NUMBER_WIDTH) << std::endl;
+    for (const Workload &workload : workloads)
+    {
+        for (long long keys : keySpaces)
+        {
+            runAll<LockedHashMap>(counters, report, workload, maxThreads, keys, ops);
+            runAll<ConcurrentStore>(counters, report, workload, maxThreads, keys, ops);
+        }
+    }
+    return report.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}